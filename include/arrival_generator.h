@@ -0,0 +1,50 @@
+#ifndef ARRIVAL_GENERATOR_H
+#define ARRIVAL_GENERATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "queue.h"
+#include "rng.h"
+#include "transport.h"
+
+#define ARRIVAL_STREAMS 8                 // 4 approaches x entry lanes L1 and L2
+#define ARRIVAL_PROFILE_HOURS 24
+#define ARRIVAL_BATCH_WINDOW_NS 100000    // Arrivals closer together than this share one write
+#define ARRIVAL_REPORT_NS 1000000000LL    // Rate report interval
+
+// Arrival rates and the demand curve that scales them. rates are
+// vehicles/second at the profile's peak hour; each approach lane is an
+// independent Poisson process with its own RNG stream.
+typedef struct {
+    double rates[ARRIVAL_STREAMS];          // By direction * 2 + lane
+    double profile[ARRIVAL_PROFILE_HOURS];  // Relative demand per hour, peak normalised to 1
+    bool useProfile;
+    double periodSeconds;   // Wall seconds for a full 24-hour profile (86400 = real time)
+    double startHour;
+    double durationSeconds; // 0 runs until killed
+    uint64_t seed;
+} ArrivalConfig;
+
+// Next candidate arrival per stream, drawn at the stream's peak rate and
+// thinned against the profile when it comes due (Lewis-Shedler)
+typedef struct {
+    const ArrivalConfig* config;
+    Rng rng[ARRIVAL_STREAMS];
+    double next[ARRIVAL_STREAMS];  // Seconds since the start; INFINITY for a zero rate
+    long generated;
+    long thinned;
+} ArrivalProcess;
+
+void defaultArrivalConfig(ArrivalConfig* config);
+bool parseArrivalRates(ArrivalConfig* config, const char* text);
+bool loadArrivalProfile(ArrivalConfig* config, const char* path);
+double arrivalDemand(const ArrivalConfig* config, double seconds);
+
+void initArrivalProcess(ArrivalProcess* process, const ArrivalConfig* config);
+double peekArrival(const ArrivalProcess* process);
+bool nextArrival(ArrivalProcess* process, double until, Vehicle* vehicle, double* at);
+
+// Paced generation into a transport; returns false if the sink failed
+bool startArrivalGeneration(const ArrivalConfig* config, TransportKind kind, const char* path);
+
+#endif // ARRIVAL_GENERATOR_H
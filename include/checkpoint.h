@@ -0,0 +1,76 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "junction.h"
+
+#define CHECKPOINT_MAGIC 0x504B4356u   // "VCKP" little-endian
+#define CHECKPOINT_VERSION 2
+
+typedef struct {
+    int capacity;
+    int size;
+    float waitingTime;
+    bool isPriorityLane;
+    long drops;
+    long backpressured;
+    long grows;
+    long enqueued;
+} CheckpointQueue;
+
+// Fixed-size part of a checkpoint. Structs are stored as they are in memory,
+// so a checkpoint only loads into the build that wrote it; the sizes below
+// catch a mismatch. The header is followed by, in order: the wait and
+// emergency-latency histograms, every pool slot, the pool free list, each
+// lane's vehicles front to back as pool indices, the emergency heap, its
+// position index and the per-lane detection marks.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t vehicleSize;
+    uint32_t configSize;
+    uint64_t fileSize;
+    JunctionConfig config;
+    Rng roadRng[4];
+    ControllerState controllerState;
+    bool lightStates[NUM_LIGHTS];
+    int currentLight;
+    int lightTimer;
+    int vehicleGenTimer;
+    long tick;
+    long vehiclesIngested;
+    long vehiclesSpawned;
+    long vehiclesExited;
+    long conflictsAvoided;
+    int poolCapacity;
+    int poolFreeCount;
+    int poolInUse;
+    int poolHighWater;
+    long poolAllocations;
+    long poolExhausted;
+    CheckpointQueue queues[NUM_QUEUES];
+    int emergencyCount;
+    long emergenciesDetected;
+    long emergenciesCleared;
+    long preemptions;
+} CheckpointHeader;
+
+// Writes with write(2) only and allocates nothing, so it is safe in a child
+// forked from a multi-threaded process
+bool writeCheckpoint(const Junction* junction, const char* path);
+// The child writes from its copy-on-write view of the junction while the
+// caller keeps simulating. Returns the child's pid, or -1.
+pid_t forkCheckpoint(const Junction* junction, const char* path);
+bool waitCheckpoint(pid_t pid);
+// A new junction in exactly the state that was saved; NULL if the file is
+// missing, truncated or from a different build
+Junction* restoreJunction(const char* path);
+// What-if changes on top of a restored junction: the seed and controller
+// from config if given, preemption if config turns it on, and no built-in
+// spawner if config turns it off (a replay). Everything else stays as saved.
+void applyRestoreOverrides(Junction* junction, const JunctionConfig* config, bool seedGiven, bool controllerGiven);
+
+#endif // CHECKPOINT_H
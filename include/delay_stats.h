@@ -0,0 +1,23 @@
+#ifndef DELAY_STATS_H
+#define DELAY_STATS_H
+
+#include <stdint.h>
+
+#define DELAY_BIN_MS 250
+#define DELAY_BINS 2400     // 0-600 s; longer waits land in the last bin
+
+// Fixed-width histogram of per-vehicle waiting time. Recording is one
+// increment, and histograms from separate runs merge by adding bins.
+typedef struct {
+    uint64_t bins[DELAY_BINS];
+    uint64_t count;
+    double totalMs;
+    double maxMs;
+} DelayHistogram;
+
+void recordDelay(DelayHistogram* histogram, double delayMs);
+void mergeDelayHistogram(DelayHistogram* into, const DelayHistogram* from);
+double meanDelay(const DelayHistogram* histogram);
+double delayPercentile(const DelayHistogram* histogram, double percentile);
+
+#endif // DELAY_STATS_H
@@ -0,0 +1,63 @@
+#ifndef EVENT_SIM_H
+#define EVENT_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "junction.h"
+
+#define EVENT_POLL_MS 100    // Transport poll period; the tick loop polls every tick
+#define EVENT_HEAP_INITIAL 256
+
+typedef enum {
+    EVENT_SPAWN = 0,     // Built-in spawner, every spawnIntervalTicks
+    EVENT_POLL,          // Drain the transport; a replayed trace at each record's time
+    EVENT_LIGHT,         // Controller decision: every lightCycleMs, or CONTROLLER_DECISION_MS if adaptive
+    EVENT_LANE_CHECK,    // Front of a lane may be able to cross its stop line
+    EVENT_EXIT           // A departed vehicle has left the window
+} EventType;
+
+typedef struct {
+    double timeMs;
+    uint64_t seq;        // Ties are served in scheduling order
+    uint8_t type;
+    uint8_t queueIndex;
+    int vehicle;         // Pool index, EVENT_EXIT only
+} SimEvent;
+
+// Binary min-heap on (timeMs, seq)
+typedef struct {
+    SimEvent* events;
+    int count;
+    int capacity;
+    uint64_t nextSeq;
+} EventHeap;
+
+// Event-driven alternative to stepJunction. Vehicles still live in the
+// junction's queues and pool, but nobody moves them each tick: a vehicle's
+// stop-line arrival is computed from its speed when it enters, and lanes
+// discharge one vehicle per headway while their light is green. Cost grows
+// with the number of events, not ticks x vehicles. Cross traffic inside the
+// box is not modelled; phases never overlap except for emergency vehicles.
+typedef struct {
+    Junction* junction;
+    Transport* transport;
+    EventHeap heap;
+    double nowMs;
+    double* stopLineMs;              // By pool index: when the vehicle reaches its stop line
+    double lastDepartMs[NUM_QUEUES];
+    double checkAtMs[NUM_QUEUES];    // The one live EVENT_LANE_CHECK per lane; others are stale
+    bool checkPending[NUM_QUEUES];
+    int inFlight[4];                 // Departed but not yet exited, per road; still count toward the spawn cap
+    long lightsAtMs;                 // Whole ms of the last light update; elapsed time telescopes exactly
+    long eventsProcessed;
+} EventSim;
+
+EventSim* createEventSim(Junction* junction, Transport* transport);
+void destroyEventSim(EventSim* sim);
+bool runEventSim(EventSim* sim, double untilMs);
+int recordEventStranded(const EventSim* sim, DelayHistogram* stranded);
+
+bool pushEvent(EventHeap* heap, double timeMs, EventType type, int queueIndex, int vehicle);
+bool popEvent(EventHeap* heap, SimEvent* event);
+
+#endif // EVENT_SIM_H
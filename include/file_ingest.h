@@ -0,0 +1,48 @@
+#ifndef FILE_INGEST_H
+#define FILE_INGEST_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include "vehicle_ring.h"
+
+#define FILE_INGEST_RING_CAPACITY 4096 // Parsed vehicles waiting for the simulation; power of two
+#define FILE_INGEST_CHUNK 65536        // Bytes read per pread
+#define FILE_INGEST_MAX_LINE 256
+
+// Event-driven reader for the text transport. A background thread sleeps in
+// poll() on an inotify watch of the file's directory, reads only the bytes
+// appended since its last offset (the file is never truncated by the
+// reader), parses whole lines and pushes the vehicles into a process-local
+// ring. The simulation drains that ring like the shared-memory one, so an
+// idle frame costs no system calls. Reading starts at the end of the file as
+// it is when opened, so a restart does not replay the writer's whole history
+// as one burst; fromStart ingests the existing contents too. A file that is
+// created or replaced later is always read from its beginning.
+typedef struct {
+    char path[256];
+    const char* name;          // Points into path: the file name inside the watched directory
+    VehicleRing* ring;
+    pthread_t thread;
+    bool threadStarted;
+    int inotifyFd;
+    int stopFd;                // eventfd that wakes the thread for shutdown
+    atomic_bool stopping;
+    // Owned by the ingest thread
+    int fd;
+    off_t offset;              // Everything before this has been parsed
+    char buffer[FILE_INGEST_CHUNK + FILE_INGEST_MAX_LINE];
+    int carry;                 // Bytes of an unfinished line at the start of buffer
+    // Stats, written by the ingest thread
+    atomic_long parsed;
+    atomic_long malformed;
+    atomic_long wakeups;
+    atomic_long truncations;   // The file shrank (e.g. the generator restarted); reading resumed at 0
+    atomic_long ringFull;      // Times the thread waited for the simulation to drain the ring
+} FileIngest;
+
+FileIngest* openFileIngest(const char* path, bool fromStart);
+void closeFileIngest(FileIngest* ingest);
+
+#endif // FILE_INGEST_H
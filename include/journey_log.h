@@ -0,0 +1,61 @@
+#ifndef JOURNEY_LOG_H
+#define JOURNEY_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "queue.h"
+#include "vehicle_ring.h"
+
+#define JOURNEY_MAGIC 0x594E524Au     // "JRNY" little-endian
+#define JOURNEY_VERSION 1
+#define JOURNEY_RING_CAPACITY (1u << 16) // Records buffered between flushes; power of two
+#define JOURNEY_FLUSH_BATCH 4096         // Writer flushes once this many are pending...
+#define JOURNEY_FLUSH_MS 100             // ...or this long after the last flush
+
+// Start of a journey log file; records follow until end of file
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t tickMs;       // Simulated milliseconds per tick
+    uint32_t reserved;
+} JourneyHeader;
+
+// One completed trip, 16 bytes
+typedef struct __attribute__((packed)) {
+    uint32_t exitTick;
+    uint32_t vehicleId;
+    uint32_t waitTicks;    // Ticks spent stopped
+    uint8_t type;
+    uint8_t route;         // startDir | startLane << 2 | endDir << 4 | endLane << 6
+    uint16_t reserved;
+} JourneyRecord;
+
+// The simulation thread appends to an SPSC ring in memory; a background thread
+// drains it to disk in large writes. When the ring is full, records are dropped
+// and counted rather than stalling the simulation.
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_fast64_t head;   // Written by the simulation thread
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_fast64_t tail;   // Written by the writer thread
+    _Alignas(CACHE_LINE_SIZE) uint64_t cachedTail;         // Producer's last view of tail
+    long logged;
+    long dropped;
+    _Alignas(CACHE_LINE_SIZE) atomic_long written;
+    atomic_bool stopping;
+    bool writeFailed;
+    int fd;
+    pthread_t writer;
+    JourneyRecord records[JOURNEY_RING_CAPACITY];
+} JourneyLog;
+
+JourneyLog* openJourneyLog(const char* path, uint32_t tickMs);
+bool logJourney(JourneyLog* log, const JourneyRecord* record);
+void closeJourneyLog(JourneyLog* log);   // Flushes everything pending first
+
+static inline uint8_t encodeJourneyRoute(int startDir, int startLane, int endDir, int endLane) {
+    return (uint8_t)((startDir & 3) | (startLane & 3) << 2 | (endDir & 3) << 4 | (endLane & 3) << 6);
+}
+
+#endif // JOURNEY_LOG_H
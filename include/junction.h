@@ -0,0 +1,81 @@
+#ifndef JUNCTION_H
+#define JUNCTION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "queue.h"
+#include "transport.h"
+#include "vehicle_pool.h"
+#include "spatial_grid.h"
+#include "rng.h"
+#include "journey_log.h"
+#include "delay_stats.h"
+#include "signal_control.h"
+#include "preemption.h"
+
+#define NUM_QUEUES 12           // 4 roads x 3 lanes
+#define NUM_LIGHTS 4
+#define SIM_TICK_MS 16          // One simulation step (~60 FPS)
+#define LIGHT_CYCLE_TIME 5000   // 5 seconds
+#define VEHICLE_GEN_INTERVAL 20 // Ticks between built-in spawns
+#define EMERGENCY_PERCENT 10    // Share of built-in spawns that are emergency vehicles
+#define SPAWN_QUEUE_LIMIT 8     // The built-in spawner skips roads with this many vehicles queued
+
+// Called for every vehicle leaving a junction. Returning true means the handler
+// has taken the vehicle onward (e.g. to a neighbouring junction) and the trip
+// is not complete yet.
+typedef bool (*ExitHandler)(void* context, const Vehicle* vehicle);
+
+typedef struct {
+    int queueCapacity;
+    OverflowPolicy overflowPolicy;
+    uint64_t seed;          // Same seed, same built-in traffic
+    int lightCycleMs;       // Green time per phase
+    bool spawner;           // Built-in random arrivals; off when replaying a trace
+    int spawnIntervalTicks; // Built-in arrival rate: one spawn round per interval
+    int emergencyPercent;
+    int spawnQueueLimit;
+    ControllerKind controller;
+    bool preemption;        // Give emergency vehicles' roads the green; latency is measured either way
+} JunctionConfig;
+
+// All state needed to step one intersection, independent of SDL
+typedef struct {
+    JunctionConfig config;
+    Queue* queues[NUM_QUEUES];
+    VehiclePool* pool;      // Owns every vehicle in the queues
+    SpatialGrid* grid;      // Cross-lane conflict lookups
+    Rng roadRng[4];         // Independent stream per road for the spawner
+    JourneyLog* journeyLog; // Optional, caller-owned: receives every completed trip
+    DelayHistogram waitStats; // Waiting time of every completed trip
+    ExitHandler onExit;     // Optional
+    void* exitContext;
+    const SignalController* signal; // From config.controller; may be swapped for a custom one
+    ControllerState controllerState;
+    Preemption* emergencies; // Emergency vehicles present, for preemption and latency stats
+    bool lightStates[NUM_LIGHTS];
+    int currentLight;
+    int lightTimer;
+    int vehicleGenTimer;
+    long tick;
+    long vehiclesIngested;  // Received through a transport
+    long vehiclesSpawned;   // Created by the built-in spawner
+    long vehiclesExited;    // Left the junction through an exit
+    long conflictsAvoided;  // Times a vehicle yielded to cross traffic in the box
+} Junction;
+
+void defaultJunctionConfig(JunctionConfig* config);
+Junction* createJunction(const JunctionConfig* config);
+long countQueueDrops(const Junction* junction);
+int recordStranded(const Junction* junction, DelayHistogram* stranded);
+void destroyJunction(Junction* junction);
+void stepJunction(Junction* junction, Transport* transport);
+
+void spawnVehicles(Junction* junction, int queueLengths[4]);
+void updateLights(Junction* junction, int elapsedMs, const int laneSizes[NUM_QUEUES]);
+int updateVehiclePositions(Junction* junction);
+bool isInsideIntersection(const Vehicle* vehicle);
+bool isNearIntersection(float x, float y);
+void finishTrip(Junction* junction, const Vehicle* vehicle);
+
+#endif // JUNCTION_H
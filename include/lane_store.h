@@ -0,0 +1,56 @@
+#ifndef LANE_STORE_H
+#define LANE_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "queue.h"
+#include "junction.h"
+
+#define LANE_STORE_CAPACITY 4096
+
+#define LANE_FLAG_TURNING 0x01
+#define LANE_FLAG_PASSED  0x02
+
+// Structure-of-arrays storage for one lane, in FIFO order starting at front.
+// Hot kinematic fields are touched every tick; cold fields only on entry/exit.
+typedef struct {
+    Direction direction;
+    LanePosition lane;
+    int front;
+    int count;
+    int capacity;
+
+    // Hot
+    float* x;
+    float* y;
+    float* speed;
+    float* progress;
+    uint8_t* flags;
+
+    // Cold
+    int* vehicleId;
+    uint8_t* type;
+    uint8_t* endDirection;
+    uint8_t* endLane;
+    int* waitTime;
+} LaneStore;
+
+typedef struct {
+    LaneStore lanes[NUM_QUEUES];
+    long exited;
+    // Scratch: vehicles near the box at the start of the tick, as lane and
+    // slot, for the cross-traffic check
+    int* nearLane;
+    int* nearSlot;
+    int nearCount;
+} VehicleStore;
+
+VehicleStore* createVehicleStore(int laneCapacity);
+void destroyVehicleStore(VehicleStore* store);
+bool pushLaneVehicle(LaneStore* lane, const Vehicle* vehicle);
+int moveQueuesToStore(VehicleStore* store, Queue* queues[], VehiclePool* pool);
+int updateVehicleStore(VehicleStore* store, Junction* junction);
+void stepVehicleStore(VehicleStore* store, Junction* junction, Transport* transport);
+int recordStoreStranded(const VehicleStore* store, DelayHistogram* stranded);
+
+#endif // LANE_STORE_H
@@ -0,0 +1,48 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <stdbool.h>
+#include <pthread.h>
+#include "junction.h"
+
+#define NETWORK_PENDING_LIMIT 256   // Refused hand-offs a junction retries before dropping
+
+typedef enum { SIDE_NORTH = 0, SIDE_WEST, SIDE_EAST, SIDE_SOUTH } NetworkSide;
+
+// Vehicles leaving a junction on one side during one tick, copied by value
+typedef struct {
+    Vehicle* items;
+    int count;
+    int capacity;
+} Outbox;
+
+// One junction in the grid. Outboxes are double buffered by tick parity: in
+// tick t a node writes outbox[t & 1] and its neighbours read outbox[(t - 1) & 1],
+// so the only synchronisation needed is one barrier per tick.
+typedef struct {
+    Junction* junction;
+    int neighbour[4];           // Node index per NetworkSide, -1 at the edge of the grid
+    Outbox outbox[2][4];
+    int writeSlot;
+    Outbox pending;             // Arrivals the junction refused, retried next tick
+    long handedOff;             // Sent to a neighbour
+    long leftNetwork;           // Left through the edge of the grid
+    long arrived;               // Received from neighbours
+    long refused;               // Dropped after NETWORK_PENDING_LIMIT was reached
+} NetworkNode;
+
+// cols x rows junctions joined by road segments. A vehicle that drives off
+// one side of a junction enters the neighbour on that side in the same
+// direction of travel, one tick later.
+typedef struct {
+    int cols, rows;
+    NetworkNode* nodes;
+    long tick;
+} Network;
+
+Network* createNetwork(int cols, int rows, const JunctionConfig* config);
+void destroyNetwork(Network* network);
+void stepNetworkNode(Network* network, int index, long tick);
+bool runNetwork(Network* network, long ticks, int threadCount);
+
+#endif // NETWORK_H
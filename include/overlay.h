@@ -0,0 +1,49 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdbool.h>
+#include "junction.h"
+#include "render.h"
+#include "snapshot.h"
+
+#define OVERLAY_DEFAULT_FONT "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf"
+#define OVERLAY_FONT_SIZE 13
+#define OVERLAY_REFRESH_MS 250   // Values are resampled (and possibly re-rasterized) at most this often
+#define OVERLAY_MAX_LINES 16
+#define OVERLAY_TEXT_SIZE 96
+
+// A line of text and the texture it was last rasterized to. The texture is
+// only rebuilt when the text changes.
+typedef struct {
+    char text[OVERLAY_TEXT_SIZE];
+    SDL_Texture* texture;
+    int width, height;
+    int x, y;
+    bool dirty;
+} OverlayLine;
+
+// Telemetry panel drawn over the junction. Frame and tick counts accumulate
+// between refreshes so the displayed rates are averages, not single frames.
+typedef struct {
+    TTF_Font* font;
+    bool visible;
+    OverlayLine lines[OVERLAY_MAX_LINES];
+    int lineCount;
+    OverlayLine lightLabels[NUM_LIGHTS];
+    double windowStartMs;
+    double windowWorkMs;
+    int windowFrames;
+    long windowStartTick;
+    long rasterized;     // Line textures built so far, to keep an eye on overlay cost
+} Overlay;
+
+bool initOverlay(Overlay* overlay, const char* fontPath, int pointSize);
+void destroyOverlay(Overlay* overlay);
+void invalidateOverlay(Overlay* overlay);
+void recordOverlayFrame(Overlay* overlay, double workMs);
+void updateOverlay(Overlay* overlay, const Snapshot* snapshot, double timeScale, double nowMs);
+void drawOverlay(SDL_Renderer* renderer, Overlay* overlay, TrafficLight lights[NUM_LIGHTS]);
+
+#endif // OVERLAY_H
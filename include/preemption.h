@@ -0,0 +1,40 @@
+#ifndef PREEMPTION_H
+#define PREEMPTION_H
+
+#include <stdbool.h>
+#include "queue.h"
+#include "vehicle_pool.h"
+#include "delay_stats.h"
+
+typedef struct {
+    long detectedTick;
+    long seq;            // Detection order, breaks ties within a tick
+    int poolIndex;
+    int queueIndex;
+} EmergencyEntry;
+
+// Every emergency vehicle (type 1-3) currently in the junction, in an indexed
+// min-heap on detection order. position[] maps a pool index to its heap slot,
+// so a vehicle leaving from any lane is removed in O(log n). The head is the
+// longest-waiting emergency; serving heads in order bounds each vehicle's
+// wait by the ones detected before it.
+typedef struct {
+    EmergencyEntry* heap;
+    int count;
+    int* position;            // By pool index: heap slot, or -1
+    int poolCapacity;
+    long* seenEnqueued;       // By queue: queue->enqueued at the last detection pass
+    int queueCount;
+    long detected;
+    long cleared;
+    long preemptions;         // Times the lights were switched for an emergency
+    DelayHistogram latency;   // Detection to clearance, per vehicle
+} Preemption;
+
+Preemption* createPreemption(int poolCapacity, int queueCount);
+void destroyPreemption(Preemption* preemption);
+int detectEmergencies(Preemption* preemption, Queue* queues[], const VehiclePool* pool, long tick);
+bool clearEmergency(Preemption* preemption, int poolIndex, long tick, int tickMs);
+int preemptedQueue(const Preemption* preemption);
+
+#endif // PREEMPTION_H
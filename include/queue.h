@@ -2,10 +2,25 @@
 #define QUEUE_H
 
 #include <stdbool.h>
+#include "rng.h"
 
-#define MAX_QUEUE_SIZE 100
+#define DEFAULT_QUEUE_CAPACITY 128   // Rounded up to a power of two
+#define MAX_QUEUE_CAPACITY (1 << 20) // Growth limit for QUEUE_OVERFLOW_GROW
 #define SAFE_DISTANCE 30
 
+// What enqueue does when a lane is full
+typedef enum {
+    QUEUE_OVERFLOW_REJECT = 0,    // Refuse and count a drop; caller releases the vehicle
+    QUEUE_OVERFLOW_GROW,          // Double the ring (up to MAX_QUEUE_CAPACITY)
+    QUEUE_OVERFLOW_BACKPRESSURE   // Refuse without dropping; producer keeps it and retries
+} OverflowPolicy;
+
+typedef enum {
+    ENQUEUE_OK = 0,
+    ENQUEUE_REJECTED,
+    ENQUEUE_BACKPRESSURE
+} EnqueueResult;
+
 typedef enum {
     LANE_LEFT = 0,    // Leftmost lane (L1)
     LANE_CENTER = 1,  // Center lane (L2)
@@ -35,10 +50,15 @@ typedef struct {
     int waitTime;
     bool isPriorityLane;
     bool passedIntersection;
+    float prevX;            // Position at the start of the last step, for interpolation
+    float prevY;
 } Vehicle;
 
+// Circular queue with power-of-two capacity, indexed with a mask
 typedef struct {
-    Vehicle* items[MAX_QUEUE_SIZE];
+    Vehicle** items;
+    int capacity;
+    unsigned int mask;
     int front;
     int rear;
     int size;
@@ -46,20 +66,31 @@ typedef struct {
     LanePosition lane;
     float waitingTime;
     bool isPriorityLane;
+    OverflowPolicy overflowPolicy;
+    long drops;          // Vehicles refused under QUEUE_OVERFLOW_REJECT
+    long backpressured;  // Refusals under QUEUE_OVERFLOW_BACKPRESSURE
+    long grows;
+    long enqueued;       // Vehicles accepted so far
+    int external;        // Vehicles of this lane kept outside the ring (the SoA store); they count toward capacity
 } Queue;
 
 Queue* createQueue(Direction direction, LanePosition lane);
+Queue* createQueueWithCapacity(Direction direction, LanePosition lane, int capacity, OverflowPolicy policy);
+void destroyQueue(Queue* queue);
 bool isEmpty(Queue* queue);
 bool isFull(Queue* queue);
-void enqueue(Queue* queue, Vehicle* vehicle);
+EnqueueResult enqueue(Queue* queue, Vehicle* vehicle);
 Vehicle* dequeue(Queue* queue);
 int getSize(Queue* queue);
 Vehicle* peekFront(Queue* queue);
+Vehicle* queueAt(Queue* queue, int index);
+OverflowPolicy parseOverflowPolicy(const char* name);
 
 void updateVehiclePosition(Vehicle* vehicle);
 bool isEmergencyVehicle(Vehicle* vehicle);
 bool canProceedThroughIntersection(Vehicle* vehicle, bool trafficLights[4]);
-void setVehiclePath(Vehicle* vehicle);
+int lightForDirection(Direction direction);
+void setVehiclePath(Vehicle* vehicle, Rng* rng);
 bool isSafeDistance(Vehicle* v1, Vehicle* v2);
 bool checkCollision(Vehicle* v1, Vehicle* v2);
 bool isPriorityLaneActive(Queue* queue);
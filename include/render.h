@@ -0,0 +1,36 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include "queue.h"
+#include "snapshot.h"
+
+#define VEHICLE_TYPES 4
+
+typedef struct {
+    int x, y;
+    bool state;
+    const char* label;
+} TrafficLight;
+
+// The road layer never changes, so it is drawn once into a texture and copied
+// each frame. Vehicle rects are collected per type and filled in one call each.
+typedef struct {
+    SDL_Texture* roads;
+    bool valid;
+    SDL_Rect* vehicleRects[VEHICLE_TYPES];
+    int rectCounts[VEHICLE_TYPES];
+    int rectCapacity;
+} SceneCache;
+
+void initSceneCache(SceneCache* cache);
+void invalidateSceneCache(SceneCache* cache);
+void destroySceneCache(SceneCache* cache);
+
+void drawRoads(SDL_Renderer* renderer);
+void drawStaticScene(SDL_Renderer* renderer, SceneCache* cache);
+void drawTrafficLights(SDL_Renderer* renderer, TrafficLight lights[4]);
+void drawVehicles(SDL_Renderer* renderer, SceneCache* cache, const Snapshot* snapshot, float alpha);
+
+#endif // RENDER_H
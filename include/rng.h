@@ -0,0 +1,26 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Stream ids: one per road inside a junction, one for the external generator
+#define RNG_STREAM_ROAD(dir) ((uint64_t)(dir))
+#define RNG_STREAM_GENERATOR 4
+#define RNG_STREAM_ARRIVAL(stream) (8 + (uint64_t)(stream)) // Poisson generator, one per approach lane
+
+// PCG32 (XSH-RR): 16 bytes of state, no locking. Two generators with the same
+// seed but different streams produce uncorrelated sequences.
+typedef struct {
+    uint64_t state;
+    uint64_t inc;       // Stream selector, always odd
+} Rng;
+
+void seedRng(Rng* rng, uint64_t seed, uint64_t stream);
+uint32_t rngNext(Rng* rng);
+uint32_t rngRange(Rng* rng, uint32_t bound); // Uniform in [0, bound)
+float rngFloat(Rng* rng);                    // Uniform in [0, 1)
+double rngDouble(Rng* rng);                  // Uniform in [0, 1), 53 bits
+uint64_t rngSeedFromClock(void);             // For runs without an explicit --seed
+uint64_t parseSeed(const char* text);
+
+#endif // RNG_H
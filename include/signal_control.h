@@ -0,0 +1,50 @@
+#ifndef SIGNAL_CONTROL_H
+#define SIGNAL_CONTROL_H
+
+#include <stdbool.h>
+
+#define CONTROLLER_MIN_GREEN_MS 2000   // Adaptive controllers never cut a green shorter than this
+#define CONTROLLER_MAX_GREEN_CYCLES 2  // Actuated greens end after this many lightCycleMs regardless
+#define CONTROLLER_DECISION_MS 250     // How often the event engine consults an adaptive controller
+#define PRIORITY_LANE_ON 10            // AL2 takes the green above this many vehicles...
+#define PRIORITY_LANE_OFF 5            // ...and gives it back below this many
+#define PRIORITY_MAX_GREEN_CYCLES 3    // ...or after this many lightCycleMs, whichever comes first
+
+typedef enum {
+    CONTROLLER_FIXED = 0,    // Round robin, lightCycleMs per phase
+    CONTROLLER_ACTUATED,     // Holds a green while its road has vehicles, skips empty roads
+    CONTROLLER_MAX_PRESSURE, // Serves the road with the most queued vehicles
+    CONTROLLER_PRIORITY,     // Round robin, but AL2 takes over above 10 vehicles until below 5,
+                             // for at most PRIORITY_MAX_GREEN_CYCLES cycles at a time
+    CONTROLLER_COUNT
+} ControllerKind;
+
+// What a controller remembers between decisions; part of the junction state
+typedef struct {
+    bool priorityActive;   // AL2 hysteresis
+    int priorityYield;     // Phase changes left before AL2 may hold the green again
+    long phaseChanges;
+} ControllerState;
+
+// What a controller sees when asked for a decision
+typedef struct {
+    int currentLight;
+    bool green;            // currentLight is showing green; false before the first phase
+    int greenMs;           // How long it has been green
+    int cycleMs;           // config.lightCycleMs
+    const int* laneSizes;  // Vehicles per lane, NUM_QUEUES entries indexed road * 3 + lane
+} SignalInput;
+
+// Returns the light to turn green, or -1 to leave the lights as they are
+typedef int (*PhaseChooser)(const SignalInput* input, ControllerState* state);
+
+typedef struct {
+    const char* name;
+    PhaseChooser choosePhase;
+    bool adaptive;         // Reads lane sizes, so it needs asking more often than once per cycle
+} SignalController;
+
+const SignalController* signalController(ControllerKind kind);
+ControllerKind parseControllerKind(const char* name); // CONTROLLER_COUNT if unknown
+
+#endif // SIGNAL_CONTROL_H
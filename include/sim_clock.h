@@ -0,0 +1,21 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#define MAX_STEPS_PER_FRAME 1000 // Drop sim time beyond this to avoid a spiral of death
+
+// Fixed-timestep clock: real time feeds an accumulator that is drained in
+// whole SIM_TICK_MS steps, scaled by timeScale (1x, 10x, 100x, ...)
+typedef struct {
+    double timeScale;
+    double accumulatorMs;
+    double lastMs;
+    double stepMs;
+    long droppedSteps;
+} SimClock;
+
+void initSimClock(SimClock* clock, double stepMs, double timeScale);
+int advanceSimClock(SimClock* clock);
+float getSimClockAlpha(const SimClock* clock);
+double simClockNowMs(void);
+
+#endif // SIM_CLOCK_H
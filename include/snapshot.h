@@ -0,0 +1,64 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "junction.h"
+#include "vehicle_ring.h"
+
+#define SNAPSHOT_FRESH 4 // Set in middle when it holds a slot the reader has not seen
+
+typedef struct {
+    float x, y;
+    float prevX, prevY;     // Position at the start of the last step, for interpolation
+    int type;
+} SnapshotVehicle;
+
+// Everything the renderer and overlay read about one moment of the junction.
+// Plain copies only: nothing here points back into the simulation.
+typedef struct {
+    long tick;
+    double publishedMs;     // simClockNowMs() when the sim thread published it
+    float alpha;            // Fraction of a step left on the sim clock at that time
+    bool lightStates[NUM_LIGHTS];
+    int queueSizes[NUM_QUEUES];
+    float waitingTimes[NUM_QUEUES];
+    long drops;
+    long backpressured;
+    int poolInUse;
+    int poolCapacity;
+    int poolHighWater;
+    long poolExhausted;
+    long vehiclesExited;
+    long conflictsAvoided;
+    long droppedSteps;      // Sim time the clock gave up on to keep up
+    SnapshotVehicle* vehicles;
+    int vehicleCount;
+    int vehicleCapacity;
+} Snapshot;
+
+// Triple buffer between one writer (sim thread) and one reader (render
+// thread). The writer fills back, then swaps it with middle; the reader swaps
+// front with middle only when middle is fresh. Neither side ever waits, and
+// the reader always sees the latest complete snapshot.
+typedef struct {
+    Snapshot slots[3];
+    _Alignas(CACHE_LINE_SIZE) atomic_int middle; // Slot index | SNAPSHOT_FRESH
+    _Alignas(CACHE_LINE_SIZE) int back;          // Writer only
+    long published;
+    _Alignas(CACHE_LINE_SIZE) int front;         // Reader only
+    long consumed;
+} SnapshotBuffer;
+
+bool initSnapshot(Snapshot* snapshot, int vehicleCapacity);
+void destroySnapshot(Snapshot* snapshot);
+void captureSnapshot(Snapshot* snapshot, const Junction* junction);
+float snapshotAlpha(const Snapshot* snapshot, double nowMs, double timeScale);
+
+bool initSnapshotBuffer(SnapshotBuffer* buffer, int vehicleCapacity);
+void destroySnapshotBuffer(SnapshotBuffer* buffer);
+Snapshot* beginSnapshot(SnapshotBuffer* buffer);
+void publishSnapshot(SnapshotBuffer* buffer);
+const Snapshot* latestSnapshot(SnapshotBuffer* buffer);
+
+#endif // SNAPSHOT_H
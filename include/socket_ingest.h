@@ -0,0 +1,73 @@
+#ifndef SOCKET_INGEST_H
+#define SOCKET_INGEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "queue.h"
+#include "vehicle_ring.h"
+#include "vehicle_trace.h"
+
+#define SOCKET_INGEST_PATH "/tmp/traffic_vehicles.sock"
+#define SOCKET_INGEST_MAX_CLIENTS 64
+#define SOCKET_INGEST_RING_CAPACITY 16384 // Vehicles waiting for the simulation; power of two
+#define SOCKET_BATCH_MAGIC 0x4B435356u    // "VSCK" little-endian
+#define SOCKET_BATCH_MAX 1024             // Records per batch
+
+// Wire format: a header followed by count TraceRecords (arrivalMs unused).
+// A client that sends a bad header is disconnected.
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+} SocketBatchHeader;
+
+// One connection's slot. Counters are written by the server thread and may
+// be read at any time; a slot keeps its numbers after the client leaves
+// until a new connection needs it.
+typedef struct {
+    int fd;                    // Server thread only; -1 once the client has gone
+    atomic_bool open;
+    atomic_bool used;
+    atomic_int id;             // Connection number, in accept order
+    atomic_uint_fast64_t connectedNs;
+    atomic_uint_fast64_t lastNs;  // Last batch, or the disconnect
+    atomic_long batches;
+    atomic_long received;      // Records admitted to the ring
+    atomic_long dropped;       // Records lost because the ring was full or the route invalid
+    atomic_long protocolErrors;
+    uint8_t buffer[sizeof(SocketBatchHeader) + SOCKET_BATCH_MAX * sizeof(TraceRecord)];
+    size_t buffered;           // Bytes of an unfinished batch
+} SocketClient;
+
+// Local stream-socket server for any number of generator processes. One
+// background thread waits in epoll on the listening socket, every client
+// and a stop eventfd, decodes complete batches and pushes the vehicles into
+// a process-local ring that the simulation drains like the other
+// transports. The simulation thread never touches a socket.
+typedef struct {
+    char path[108];            // sun_path
+    int listenFd;
+    int epollFd;
+    int stopFd;
+    VehicleRing* ring;
+    pthread_t thread;
+    bool threadStarted;
+    atomic_bool stopping;
+    int nextId;
+    atomic_int connected;
+    atomic_long accepted;
+    atomic_long rejected;      // Connections refused because every slot was busy
+    SocketClient clients[SOCKET_INGEST_MAX_CLIENTS];
+} SocketIngest;
+
+SocketIngest* openSocketIngest(const char* path);
+void closeSocketIngest(SocketIngest* ingest);
+void printSocketClients(const SocketIngest* ingest, FILE* out);
+
+// Client side: blocking connect and batch send, for traffic_generator
+int connectVehicleSocket(const char* path);
+bool sendVehicleBatch(int fd, const Vehicle* vehicles, int count);
+
+#endif // SOCKET_INGEST_H
@@ -0,0 +1,36 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <stdbool.h>
+#include "queue.h"
+
+#define GRID_CELL_SIZE SAFE_DISTANCE
+#define GRID_MARGIN 60   // Vehicles spawn and exit just outside the window
+
+typedef struct {
+    Vehicle* vehicle;
+    int queueIndex;
+    int next;          // Next entry in the same cell, or -1
+} GridEntry;
+
+// Uniform hash grid over the window, rebuilt once per tick. Each cell heads a
+// chain of entries; only cells used last tick are reset, so a rebuild costs
+// O(vehicles) however large the grid is.
+typedef struct {
+    int cols;
+    int rows;
+    int* cellHead;
+    int* usedCells;
+    int usedCount;
+    GridEntry* entries;
+    int count;
+    int capacity;
+} SpatialGrid;
+
+SpatialGrid* createSpatialGrid(int capacity);
+void destroySpatialGrid(SpatialGrid* grid);
+void rebuildSpatialGrid(SpatialGrid* grid, Queue* queues[], int queueCount);
+const Vehicle* findConflict(const SpatialGrid* grid, float x, float y, int queueIndex,
+                            bool (*filter)(const Vehicle* other));
+
+#endif // SPATIAL_GRID_H
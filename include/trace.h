@@ -0,0 +1,55 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Scoped hot-path tracing, exported as Chrome trace event JSON (chrome://tracing,
+// ui.perfetto.dev). Build with `make TRACE=1`; otherwise every macro compiles out.
+//
+//   TRACE_SCOPE("draw");   // records [here, end of enclosing block)
+//
+// Each thread writes complete events into its own ring, keeping the most recent
+// TRACE_BUFFER_EVENTS. The rings are written to the trace file on exit and
+// whenever SIGUSR1 arrives (checked at the next TRACE_POLL).
+
+#define TRACE_BUFFER_EVENTS (1 << 16)
+#define TRACE_DEFAULT_PATH "trace.json"
+
+typedef struct {
+    const char* name;   // Must be a string literal or otherwise outlive the run
+    uint64_t startNs;
+} TraceScope;
+
+static inline uint64_t traceNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void traceInit(const char* path);
+void traceRecord(const char* name, uint64_t startNs, uint64_t endNs);
+void tracePoll(void);
+void traceDump(void);
+void traceShutdown(void);
+
+static inline void endTraceScope(TraceScope* scope) {
+    traceRecord(scope->name, scope->startNs, traceNowNs());
+}
+
+#ifdef TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) \
+    TraceScope TRACE_CONCAT(traceScope, __LINE__) __attribute__((cleanup(endTraceScope))) = {(name), traceNowNs()}
+#define TRACE_INIT(path) traceInit(path)
+#define TRACE_POLL() tracePoll()
+#define TRACE_SHUTDOWN() traceShutdown()
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_INIT(path) ((void)0)
+#define TRACE_POLL() ((void)0)
+#define TRACE_SHUTDOWN() ((void)0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,33 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "queue.h"
+#include "vehicle_pool.h"
+#include "vehicle_trace.h"
+
+// Feeds a recorded arrival trace into the lanes at its recorded times. The
+// trace is read straight from its mapping and released behind the cursor,
+// so memory stays flat however long the recording. The first record arrives
+// at simulated time 0. arrivalMs is 32 bits; a stamp that jumps back by more
+// than half the range is taken as a wrap, so traces longer than 49 days keep
+// counting up.
+typedef struct {
+    TraceReader* reader;
+    const TraceRecord* pending;  // Next record to inject, NULL at the end
+    double pendingMs;
+    uint32_t firstStampMs;
+    uint32_t lastStampMs;
+    uint64_t epochMs;            // 2^32 per wrap seen so far
+    long injected;
+    long rejected;               // Lane full under the reject policy, or an invalid route
+    long outOfOrder;             // Stamped earlier than the record before it; injected at once
+} TraceReplay;
+
+TraceReplay* openTraceReplay(const char* path);
+void closeTraceReplay(TraceReplay* replay);
+int replayArrivals(TraceReplay* replay, Queue* queues[], VehiclePool* pool, double nowMs);
+double nextReplayMs(const TraceReplay* replay);
+
+#endif // TRACE_REPLAY_H
@@ -1,7 +1,11 @@
 #ifndef TRAFFIC_GENERATOR_H
 #define TRAFFIC_GENERATOR_H
 
+#include <stdbool.h>
+#include <stdio.h>
 #include "queue.h"
+#include "vehicle_ring.h"
+#include "rng.h"
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
@@ -9,8 +13,15 @@
 #define LANE_WIDTH (ROAD_WIDTH/3)
 #define VEHICLE_SIZE 20
 
-void generateVehicle(const char* filename);
-void startVehicleGeneration(const char* filename);
+void placeVehicleAtEntry(Vehicle* vehicle);
+void buildVehicle(Vehicle* vehicle, Rng* rng);
+void buildVehicleOnLane(Vehicle* vehicle, Rng* rng, Direction direction, LanePosition lane);
+void generateVehicle(const char* filename, Rng* rng);
+bool generateVehicleToRing(VehicleRing* ring, Rng* rng);
+void startVehicleGeneration(const char* filename, uint64_t seed);
+void startVehicleGenerationToRing(VehicleRing* ring, uint64_t seed);
+void startVehicleGenerationToSocket(const char* path, uint64_t seed, int batch);
 void writeVehicleToFile(Vehicle* vehicle, const char* filename);
+void writeVehicleLine(FILE* file, const Vehicle* vehicle);
 
 #endif
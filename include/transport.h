@@ -0,0 +1,42 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdbool.h>
+#include "queue.h"
+#include "vehicle_ring.h"
+#include "vehicle_pool.h"
+#include "file_ingest.h"
+#include "socket_ingest.h"
+#include "trace_replay.h"
+
+#define RING_DRAIN_BATCH 256
+
+// How vehicles get from the generator into the simulator
+typedef enum {
+    TRANSPORT_NONE = 0,
+    TRANSPORT_FILE,    // Text lines appended to vehicles.txt, read by a background inotify watcher
+    TRANSPORT_SHM,     // POSIX shared-memory ring
+    TRANSPORT_SOCKET,  // Unix-domain socket server, any number of generator clients
+    TRANSPORT_REPLAY,  // Recorded binary trace, injected at its recorded simulated times
+    TRANSPORT_COUNT
+} TransportKind;
+
+typedef struct {
+    TransportKind kind;
+    const char* path;   // File path, shared-memory name, socket path or trace file
+    VehicleRing* ring;
+    FileIngest* ingest;
+    SocketIngest* server;
+    TraceReplay* replay;
+} Transport;
+
+bool openTransport(Transport* transport, TransportKind kind, const char* path, bool fromStart);
+void closeTransport(Transport* transport);
+int pollTransport(Transport* transport, Queue* queues[], VehiclePool* pool, double nowMs);
+TransportKind parseTransportKind(const char* name); // TRANSPORT_COUNT if unknown
+
+bool parseVehicleLine(const char* line, Vehicle* vehicle);
+EnqueueResult admitVehicle(Queue* queues[], VehiclePool* pool, const Vehicle* source);
+int processVehiclesFromRing(Queue* queues[], VehiclePool* pool, VehicleRing* ring);
+
+#endif // TRANSPORT_H
@@ -0,0 +1,27 @@
+#ifndef VEHICLE_POOL_H
+#define VEHICLE_POOL_H
+
+#include "queue.h"
+
+#define VEHICLE_POOL_CAPACITY 8192
+
+// Fixed-capacity slab of Vehicles with a LIFO free list of slot indices.
+// Allocation and release are O(1) and never call malloc after creation.
+typedef struct {
+    Vehicle* slots;
+    int* freeList;
+    int freeCount;
+    int capacity;
+    int inUse;
+    int highWater;     // Most vehicles ever live at once
+    long allocations;
+    long exhausted;    // Allocations refused because the pool was empty
+} VehiclePool;
+
+VehiclePool* createVehiclePool(int capacity);
+void destroyVehiclePool(VehiclePool* pool);
+Vehicle* allocVehicle(VehiclePool* pool);
+void freeVehicle(VehiclePool* pool, Vehicle* vehicle);
+int vehiclePoolIndex(const VehiclePool* pool, const Vehicle* vehicle);
+
+#endif // VEHICLE_POOL_H
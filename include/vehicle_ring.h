@@ -0,0 +1,49 @@
+#ifndef VEHICLE_RING_H
+#define VEHICLE_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "queue.h"
+
+#define VEHICLE_RING_NAME "/traffic_vehicles"
+#define VEHICLE_RING_CAPACITY 4096   // Must be a power of two
+#define VEHICLE_RING_MAGIC 0x56524E47 // "VRNG"
+#define CACHE_LINE_SIZE 64
+
+// Layout of the shared-memory segment. head is only written by the producer
+// and tail only by the consumer; each sits on its own cache line.
+typedef struct {
+    uint32_t magic;
+    uint32_t recordSize;
+    uint32_t capacity;
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_fast64_t head;
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_fast64_t tail;
+    _Alignas(CACHE_LINE_SIZE) Vehicle slots[];
+} VehicleRingShared;
+
+// Single-producer/single-consumer ring of fixed-size vehicle records
+typedef struct {
+    VehicleRingShared* shared;
+    size_t mappedSize;
+    uint32_t mask;
+    uint64_t cachedHead;   // Consumer's last view of head
+    uint64_t cachedTail;   // Producer's last view of tail
+    bool owner;            // Created the segment, unlinks it on close
+    bool local;            // Heap memory inside one process, see createLocalVehicleRing
+    char name[64];
+} VehicleRing;
+
+VehicleRing* openVehicleRing(const char* name, uint32_t capacity);
+VehicleRing* createLocalVehicleRing(uint32_t capacity);
+void closeVehicleRing(VehicleRing* ring);
+
+// Producer side: fill the reserved slot in place, then publish it
+Vehicle* reserveVehicleSlot(VehicleRing* ring);
+void publishVehicleSlot(VehicleRing* ring);
+
+// Consumer side: borrow up to max contiguous records, then release them
+uint32_t peekVehicleBatch(VehicleRing* ring, Vehicle** first, uint32_t max);
+void releaseVehicleBatch(VehicleRing* ring, uint32_t count);
+
+#endif // VEHICLE_RING_H
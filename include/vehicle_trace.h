@@ -0,0 +1,68 @@
+#ifndef VEHICLE_TRACE_H
+#define VEHICLE_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "queue.h"
+
+#define TRACE_MAGIC 0x43525456u        // "VTRC" little-endian
+#define TRACE_VERSION 1
+#define TRACE_WRITER_CHUNK (4u << 20)  // Bytes mapped at a time while writing
+#define TRACE_READER_RELEASE (16u << 20) // Bytes read before the pages behind the cursor are dropped
+
+#define TRACE_FLAG_TURNING 0x01
+#define TRACE_FLAG_PASSED  0x02
+
+// File header. recordCount is filled in when the writer is closed.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint64_t recordCount;
+    uint32_t flags;
+    uint32_t reserved[3];
+} TraceHeader;
+
+// One arrival, 16 bytes. Positions are not stored: they follow from the
+// start road and lane (see placeVehicleAtEntry).
+typedef struct __attribute__((packed)) {
+    uint32_t arrivalMs;    // Simulated time the vehicle enters the model
+    uint32_t vehicleId;
+    uint16_t speedCenti;   // speed * 100
+    uint16_t waitTime;
+    uint8_t type;
+    uint8_t route;         // startDir | startLane << 2 | endDir << 4 | endLane << 6
+    uint8_t flags;
+    uint8_t reserved;
+} TraceRecord;
+
+typedef struct {
+    int fd;
+    const uint8_t* base;
+    size_t mappedSize;
+    const TraceRecord* records;
+    uint64_t count;
+    uint64_t cursor;
+    size_t released;       // Mapping bytes already handed back to the kernel
+} TraceReader;
+
+typedef struct {
+    int fd;
+    uint8_t* window;       // Currently mapped chunk of the file
+    uint64_t windowOffset;
+    uint64_t count;
+} TraceWriter;
+
+void encodeTraceRecord(const Vehicle* vehicle, uint32_t arrivalMs, TraceRecord* record);
+void decodeTraceRecord(const TraceRecord* record, Vehicle* vehicle);
+
+TraceReader* openTraceReader(const char* path);
+const TraceRecord* nextTraceRecord(TraceReader* reader);
+void closeTraceReader(TraceReader* reader);
+
+TraceWriter* openTraceWriter(const char* path);
+bool writeTraceRecord(TraceWriter* writer, const TraceRecord* record);
+bool closeTraceWriter(TraceWriter* writer);
+
+#endif // VEHICLE_TRACE_H
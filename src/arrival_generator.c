@@ -0,0 +1,285 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "arrival_generator.h"
+#include "traffic_generator.h"
+#include "socket_ingest.h"
+
+#define FILE_SINK_BUFFER (1 << 20)
+
+// Weekday demand with morning and evening peaks, hour 0 to 23
+static const double DEFAULT_PROFILE[ARRIVAL_PROFILE_HOURS] = {
+    0.10, 0.07, 0.05, 0.05, 0.08, 0.20, 0.50, 0.90, 1.00, 0.75, 0.60, 0.60,
+    0.65, 0.62, 0.60, 0.70, 0.85, 0.95, 0.80, 0.55, 0.40, 0.30, 0.22, 0.15
+};
+
+// Where generated vehicles go: one open file, ring or connection for the run
+typedef struct {
+    TransportKind kind;
+    const char* path;
+    FILE* file;
+    VehicleRing* ring;
+    int fd;
+    long stalls;       // Waits for the simulator to drain a full ring
+    long reconnects;
+} ArrivalSink;
+
+void defaultArrivalConfig(ArrivalConfig* config) {
+    memset(config, 0, sizeof(*config));
+    memcpy(config->profile, DEFAULT_PROFILE, sizeof(DEFAULT_PROFILE));
+    config->periodSeconds = 86400.0;
+}
+
+// "R" splits R vehicles/second evenly over the approach lanes; eight
+// comma-separated values give A-L1, A-L2, B-L1, ... D-L2 individually
+bool parseArrivalRates(ArrivalConfig* config, const char* text) {
+    double values[ARRIVAL_STREAMS];
+    int count = 0;
+    const char* p = text;
+    while (*p && count < ARRIVAL_STREAMS) {
+        char* end;
+        values[count] = strtod(p, &end);
+        if (end == p || values[count] < 0) return false;
+        count++;
+        p = end;
+        if (*p == ',') p++;
+        else if (*p) return false;
+    }
+    if (*p) return false;
+    if (count == 1) {
+        for (int i = 0; i < ARRIVAL_STREAMS; i++) config->rates[i] = values[0] / ARRIVAL_STREAMS;
+    } else if (count == ARRIVAL_STREAMS) {
+        memcpy(config->rates, values, sizeof(values));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// "default" selects the built-in weekday curve; anything else is a file of
+// 24 numbers separated by whitespace or commas. Either way the peak becomes 1.
+bool loadArrivalProfile(ArrivalConfig* config, const char* path) {
+    double profile[ARRIVAL_PROFILE_HOURS];
+    if (strcmp(path, "default") == 0) {
+        memcpy(profile, DEFAULT_PROFILE, sizeof(profile));
+    } else {
+        FILE* file = fopen(path, "r");
+        if (!file) {
+            perror(path);
+            return false;
+        }
+        int count = 0;
+        while (count < ARRIVAL_PROFILE_HOURS && fscanf(file, " %lf ,", &profile[count]) == 1) count++;
+        fclose(file);
+        if (count != ARRIVAL_PROFILE_HOURS) {
+            fprintf(stderr, "%s: expected %d hourly values, read %d\n", path, ARRIVAL_PROFILE_HOURS, count);
+            return false;
+        }
+    }
+    double peak = 0.0;
+    for (int h = 0; h < ARRIVAL_PROFILE_HOURS; h++) {
+        if (profile[h] < 0) return false;
+        if (profile[h] > peak) peak = profile[h];
+    }
+    if (peak <= 0) return false;
+    for (int h = 0; h < ARRIVAL_PROFILE_HOURS; h++) config->profile[h] = profile[h] / peak;
+    config->useProfile = true;
+    return true;
+}
+
+// Share of the peak rate in effect this many seconds into the run, linear
+// between the hourly points
+double arrivalDemand(const ArrivalConfig* config, double seconds) {
+    if (!config->useProfile) return 1.0;
+    double hour = fmod(config->startHour + seconds * ARRIVAL_PROFILE_HOURS / config->periodSeconds, ARRIVAL_PROFILE_HOURS);
+    int h = (int)hour;
+    double frac = hour - h;
+    return config->profile[h] * (1.0 - frac) + config->profile[(h + 1) % ARRIVAL_PROFILE_HOURS] * frac;
+}
+
+static double exponentialGap(Rng* rng, double rate) {
+    return -log1p(-rngDouble(rng)) / rate;
+}
+
+void initArrivalProcess(ArrivalProcess* process, const ArrivalConfig* config) {
+    memset(process, 0, sizeof(*process));
+    process->config = config;
+    for (int i = 0; i < ARRIVAL_STREAMS; i++) {
+        seedRng(&process->rng[i], config->seed, RNG_STREAM_ARRIVAL(i));
+        process->next[i] = config->rates[i] > 0 ? exponentialGap(&process->rng[i], config->rates[i]) : INFINITY;
+    }
+}
+
+// Earliest candidate; a lower bound on the next accepted arrival
+double peekArrival(const ArrivalProcess* process) {
+    double earliest = INFINITY;
+    for (int i = 0; i < ARRIVAL_STREAMS; i++) {
+        if (process->next[i] < earliest) earliest = process->next[i];
+    }
+    return earliest;
+}
+
+// Builds the next arrival due at or before until, in time order across all
+// streams. A stream only draws from its own RNG, so changing one lane's rate
+// leaves the others' arrivals unchanged.
+bool nextArrival(ArrivalProcess* process, double until, Vehicle* vehicle, double* at) {
+    const ArrivalConfig* config = process->config;
+    for (;;) {
+        int stream = 0;
+        for (int i = 1; i < ARRIVAL_STREAMS; i++) {
+            if (process->next[i] < process->next[stream]) stream = i;
+        }
+        double t = process->next[stream];
+        if (t > until) return false;
+        Rng* rng = &process->rng[stream];
+        process->next[stream] = t + exponentialGap(rng, config->rates[stream]);
+        if (config->useProfile && rngDouble(rng) >= arrivalDemand(config, t)) {
+            process->thinned++;
+            continue;
+        }
+        buildVehicleOnLane(vehicle, rng, (Direction)(stream / 2), (LanePosition)(stream % 2));
+        *at = t;
+        process->generated++;
+        return true;
+    }
+}
+
+static int64_t elapsedNs(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+// Absolute deadline, so time spent generating and writing never accumulates as drift
+static void sleepUntil(const struct timespec* start, int64_t offsetNs) {
+    struct timespec deadline = {
+        start->tv_sec + (time_t)(offsetNs / 1000000000LL),
+        start->tv_nsec + (long)(offsetNs % 1000000000LL)
+    };
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {}
+}
+
+static bool openSink(ArrivalSink* sink, TransportKind kind, const char* path) {
+    memset(sink, 0, sizeof(*sink));
+    sink->kind = kind;
+    sink->fd = -1;
+    if (kind == TRANSPORT_SHM) {
+        sink->path = path ? path : VEHICLE_RING_NAME;
+        sink->ring = openVehicleRing(sink->path, VEHICLE_RING_CAPACITY);
+    } else if (kind == TRANSPORT_SOCKET) {
+        sink->path = path ? path : SOCKET_INGEST_PATH;
+        while ((sink->fd = connectVehicleSocket(sink->path)) < 0) usleep(100 * 1000); // Simulator not up yet
+        return true;
+    } else {
+        sink->path = path ? path : "vehicles.txt";
+        sink->file = fopen(sink->path, "a");
+        if (sink->file) setvbuf(sink->file, NULL, _IOFBF, FILE_SINK_BUFFER);
+    }
+    if (!sink->ring && !sink->file) {
+        perror(sink->path);
+        return false;
+    }
+    return true;
+}
+
+static void closeSink(ArrivalSink* sink) {
+    if (sink->file) fclose(sink->file);
+    if (sink->ring) closeVehicleRing(sink->ring);
+    if (sink->fd >= 0) close(sink->fd);
+}
+
+// One write per batch: a single flush, a run of ring slots or one socket frame
+static bool writeSink(ArrivalSink* sink, const Vehicle* vehicles, int count) {
+    switch (sink->kind) {
+        case TRANSPORT_SHM:
+            for (int i = 0; i < count; i++) {
+                Vehicle* slot;
+                while (!(slot = reserveVehicleSlot(sink->ring))) {
+                    sink->stalls++;
+                    usleep(100);
+                }
+                *slot = vehicles[i];
+                publishVehicleSlot(sink->ring);
+            }
+            return true;
+        case TRANSPORT_SOCKET:
+            while (!sendVehicleBatch(sink->fd, vehicles, count)) {
+                close(sink->fd);
+                while ((sink->fd = connectVehicleSocket(sink->path)) < 0) usleep(100 * 1000);
+                sink->reconnects++;
+            }
+            return true;
+        default:
+            for (int i = 0; i < count; i++) writeVehicleLine(sink->file, &vehicles[i]);
+            return fflush(sink->file) == 0;
+    }
+}
+
+bool startArrivalGeneration(const ArrivalConfig* config, TransportKind kind, const char* path) {
+    ArrivalSink sink;
+    if (!openSink(&sink, kind, path)) return false;
+    ArrivalProcess process;
+    initArrivalProcess(&process, config);
+    double peakRate = 0.0;
+    for (int i = 0; i < ARRIVAL_STREAMS; i++) peakRate += config->rates[i];
+
+    static Vehicle batch[SOCKET_BATCH_MAX];
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t durationNs = (int64_t)(config->durationSeconds * 1e9);
+    int64_t reportNs = ARRIVAL_REPORT_NS, reportedNs = 0;
+    long reported = 0;
+    double maxLag = 0.0;
+    bool ok = true;
+
+    while (ok) {
+        int64_t nowNs = elapsedNs(&start);
+        bool last = durationNs > 0 && nowNs >= durationNs;
+        double until = (last ? durationNs : nowNs) / 1e9;
+
+        // Everything now due, in batches of at most one socket frame
+        int count;
+        do {
+            count = 0;
+            double at;
+            while (count < SOCKET_BATCH_MAX && nextArrival(&process, until, &batch[count], &at)) {
+                if (nowNs / 1e9 - at > maxLag) maxLag = nowNs / 1e9 - at;
+                count++;
+            }
+            if (count > 0 && !writeSink(&sink, batch, count)) ok = false;
+        } while (ok && count == SOCKET_BATCH_MAX);
+
+        if (last || nowNs >= reportNs) {
+            double seconds = (nowNs - reportedNs) / 1e9;
+            fprintf(stderr, "%8.1f s  demand %4.2f  target %9.0f veh/s  sent %9.0f veh/s  max lag %6.2f ms  ring stalls %ld\n",
+                nowNs / 1e9, arrivalDemand(config, nowNs / 1e9), peakRate * arrivalDemand(config, nowNs / 1e9),
+                seconds > 0 ? (process.generated - reported) / seconds : 0.0, maxLag * 1000.0, sink.stalls);
+            reported = process.generated;
+            reportedNs = nowNs;
+            maxLag = 0.0;
+            while (reportNs <= nowNs) reportNs += ARRIVAL_REPORT_NS;
+        }
+        if (last) break;
+
+        // Sleep to the next arrival, but no less than the batch window
+        double next = peekArrival(&process);
+        int64_t deadline = next < INFINITY ? (int64_t)(next * 1e9) : reportNs;
+        if (deadline < nowNs + ARRIVAL_BATCH_WINDOW_NS) deadline = nowNs + ARRIVAL_BATCH_WINDOW_NS;
+        if (deadline > reportNs) deadline = reportNs;
+        if (durationNs > 0 && deadline > durationNs) deadline = durationNs;
+        sleepUntil(&start, deadline);
+    }
+
+    fprintf(stderr, "generated %ld vehicles (%ld thinned by the profile), %ld ring stalls, %ld reconnects\n",
+        process.generated, process.thinned, sink.stalls, sink.reconnects);
+    closeSink(&sink);
+    return ok;
+}
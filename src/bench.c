@@ -0,0 +1,397 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <sched.h>
+#include "junction.h"
+#include "traffic_generator.h"
+#include "transport.h"
+#ifdef BENCH_RENDER
+#include "render.h"
+#endif
+
+// Every result is one JSON object per line on stdout so runs can be diffed
+// and collected over time: ./bench > results.jsonl
+
+#define BENCH_SEED 12345
+#define QUEUE_BENCH_OPS 20000000L
+#define TICK_BENCH_TICKS 200000L
+#define INGEST_BENCH_RECORDS 400000L
+#define FILE_BENCH_MAX_POLLS 10000L     // Each file poll reopens the file to append every record
+#define RENDER_BENCH_FRAMES 2000L
+
+static const int TICK_DENSITIES[] = {1, 4, 16, 64};      // Vehicles per entry lane
+static const int INGEST_BATCHES[] = {1, 64, 1024};      // Records per poll
+static long scaleDivisor = 1;
+static volatile long sink;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long heapInUse(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return (long)mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+typedef struct {
+    double start;
+    double elapsed;     // Only the timed sections, see pauseBench/resumeBench
+    long poolAllocs;
+    long heapStart;
+} BenchRun;
+
+static void beginBench(BenchRun* run, const VehiclePool* pool) {
+    run->elapsed = 0;
+    run->poolAllocs = pool ? pool->allocations : 0;
+    run->heapStart = heapInUse();
+    run->start = nowSeconds();
+}
+
+static void pauseBench(BenchRun* run) { run->elapsed += nowSeconds() - run->start; }
+static void resumeBench(BenchRun* run) { run->start = nowSeconds(); }
+
+// params is a JSON fragment ending in a comma, or ""
+static void reportBench(BenchRun* run, const VehiclePool* pool, const char* name,
+                        const char* params, const char* unit, long ops) {
+    double seconds = run->elapsed;
+    printf("{\"bench\":\"%s\",%s\"unit\":\"%s\",\"ops\":%ld,\"seconds\":%.6f,"
+           "\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f,\"pool_allocs\":%ld,\"heap_bytes\":%ld}\n",
+           name, params, unit, ops, seconds,
+           ops > 0 ? seconds * 1e9 / ops : 0.0,
+           seconds > 0 ? ops / seconds : 0.0,
+           pool ? pool->allocations - run->poolAllocs : 0,
+           heapInUse() - run->heapStart);
+    fflush(stdout);
+}
+
+static void drainJunction(Junction* junction) {
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        while (!isEmpty(junction->queues[i])) freeVehicle(junction->pool, dequeue(junction->queues[i]));
+    }
+}
+
+static void buildLaneVehicle(Vehicle* vehicle, Rng* rng, int dir, int lane) {
+    memset(vehicle, 0, sizeof(*vehicle));
+    vehicle->vehicleId = rngRange(rng, 1000);
+    vehicle->startDirection = dir;
+    vehicle->startLane = lane;
+    vehicle->speed = 2.0f;
+    setVehiclePath(vehicle, rng);
+    placeVehicleAtEntry(vehicle);
+    vehicle->prevX = vehicle->x;
+    vehicle->prevY = vehicle->y;
+}
+
+// Keeps every entry lane (left and center of each road) at the target occupancy
+static void topUpLanes(Junction* junction, Rng* rng, int density) {
+    for (int dir = 0; dir < 4; dir++) {
+        for (int lane = 0; lane < 2; lane++) {
+            Queue* queue = junction->queues[dir * 3 + lane];
+            while (getSize(queue) < density) {
+                Vehicle* vehicle = allocVehicle(junction->pool);
+                if (!vehicle) return;
+                buildLaneVehicle(vehicle, rng, dir, lane);
+                if (enqueue(queue, vehicle) != ENQUEUE_OK) {
+                    freeVehicle(junction->pool, vehicle);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void benchQueueOps(void) {
+    static Vehicle vehicles[512];
+    Queue* queue = createQueueWithCapacity(DIRECTION_SOUTH, LANE_LEFT, 1024, QUEUE_OVERFLOW_REJECT);
+    if (!queue) return;
+    long ops = QUEUE_BENCH_OPS / scaleDivisor;
+    BenchRun run;
+
+    beginBench(&run, NULL);
+    for (long i = 0; i < ops; i++) {
+        enqueue(queue, &vehicles[i & 511]);
+        sink += dequeue(queue)->vehicleId;
+    }
+    pauseBench(&run);
+    reportBench(&run, NULL, "queue_enqueue_dequeue", "", "pair", ops);
+
+    long bursts = ops / 512;
+    beginBench(&run, NULL);
+    for (long b = 0; b < bursts; b++) {
+        for (int i = 0; i < 512; i++) enqueue(queue, &vehicles[i]);
+        for (int i = 0; i < 512; i++) sink += queueAt(queue, i)->vehicleId;
+        while (!isEmpty(queue)) dequeue(queue);
+    }
+    pauseBench(&run);
+    reportBench(&run, NULL, "queue_burst", "\"burst\":512,", "vehicle", bursts * 512);
+    destroyQueue(queue);
+}
+
+static void benchTicks(void) {
+    for (size_t d = 0; d < sizeof(TICK_DENSITIES) / sizeof(TICK_DENSITIES[0]); d++) {
+        JunctionConfig config;
+        defaultJunctionConfig(&config);
+        config.seed = BENCH_SEED;
+        Junction* junction = createJunction(&config);
+        if (!junction) return;
+        Rng rng;
+        seedRng(&rng, BENCH_SEED, RNG_STREAM_GENERATOR);
+        long ticks = TICK_BENCH_TICKS / scaleDivisor;
+        long exited = 0;
+        BenchRun run;
+
+        beginBench(&run, junction->pool);
+        pauseBench(&run);
+        int laneSizes[NUM_QUEUES];
+        for (long t = 0; t < ticks; t++) {
+            topUpLanes(junction, &rng, TICK_DENSITIES[d]);
+            for (int i = 0; i < NUM_QUEUES; i++) laneSizes[i] = junction->queues[i]->size;
+            resumeBench(&run);
+            exited += updateVehiclePositions(junction);
+            updateLights(junction, SIM_TICK_MS, laneSizes);
+            pauseBench(&run);
+        }
+        char params[64];
+        snprintf(params, sizeof(params), "\"density\":%d,\"exited\":%ld,", TICK_DENSITIES[d], exited);
+        reportBench(&run, junction->pool, "tick_update", params, "tick", ticks);
+        destroyJunction(junction);
+    }
+}
+
+// Times the simulation side only: the records are parsed by the ingest
+// thread before the clock resumes, as they would be between frames
+static void benchFileIngest(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/bench_vehicles_%d.txt", (int)getpid());
+    unlink(path);
+    Transport transport;
+    if (!openTransport(&transport, TRANSPORT_FILE, path, false)) return;
+    long written = 0;
+
+    for (size_t b = 0; b < sizeof(INGEST_BATCHES) / sizeof(INGEST_BATCHES[0]); b++) {
+        JunctionConfig config;
+        defaultJunctionConfig(&config);
+        config.queueCapacity = 2048;
+        Junction* junction = createJunction(&config);
+        if (!junction) break;
+        Rng rng;
+        seedRng(&rng, BENCH_SEED, RNG_STREAM_GENERATOR);
+        int batch = INGEST_BATCHES[b];
+        long polls = INGEST_BENCH_RECORDS / scaleDivisor / batch;
+        if (polls > FILE_BENCH_MAX_POLLS / scaleDivisor) polls = FILE_BENCH_MAX_POLLS / scaleDivisor;
+        long ingested = 0;
+        BenchRun run;
+
+        beginBench(&run, junction->pool);
+        pauseBench(&run);
+        for (long p = 0; p < polls; p++) {
+            for (int i = 0; i < batch; i++) {
+                Vehicle vehicle;
+                buildVehicle(&vehicle, &rng);
+                writeVehicleToFile(&vehicle, path);
+            }
+            written += batch;
+            while (atomic_load(&transport.ingest->parsed) < written) usleep(50);
+            resumeBench(&run);
+            ingested += pollTransport(&transport, junction->queues, junction->pool, 0);
+            pauseBench(&run);
+            drainJunction(junction);
+        }
+        char params[64];
+        snprintf(params, sizeof(params), "\"transport\":\"file\",\"batch\":%d,", batch);
+        reportBench(&run, junction->pool, "ingest", params, "record", ingested);
+        destroyJunction(junction);
+    }
+    closeTransport(&transport);
+    unlink(path);
+}
+
+static void benchRingIngest(void) {
+    char name[64];
+    snprintf(name, sizeof(name), "/bench_ring_%d", (int)getpid());
+    VehicleRing* ring = openVehicleRing(name, VEHICLE_RING_CAPACITY);
+    if (!ring) return;
+
+    for (size_t b = 0; b < sizeof(INGEST_BATCHES) / sizeof(INGEST_BATCHES[0]); b++) {
+        JunctionConfig config;
+        defaultJunctionConfig(&config);
+        config.queueCapacity = 2048;
+        Junction* junction = createJunction(&config);
+        if (!junction) break;
+        Rng rng;
+        seedRng(&rng, BENCH_SEED, RNG_STREAM_GENERATOR);
+        int batch = INGEST_BATCHES[b];
+        long polls = INGEST_BENCH_RECORDS * 10 / scaleDivisor / batch;
+        long ingested = 0;
+        BenchRun run;
+
+        beginBench(&run, junction->pool);
+        pauseBench(&run);
+        for (long p = 0; p < polls; p++) {
+            for (int i = 0; i < batch; i++) generateVehicleToRing(ring, &rng);
+            resumeBench(&run);
+            ingested += processVehiclesFromRing(junction->queues, junction->pool, ring);
+            pauseBench(&run);
+            drainJunction(junction);
+        }
+        char params[64];
+        snprintf(params, sizeof(params), "\"transport\":\"shm\",\"batch\":%d,", batch);
+        reportBench(&run, junction->pool, "ingest", params, "record", ingested);
+        destroyJunction(junction);
+    }
+    closeVehicleRing(ring);
+}
+
+// End to end: encode and send on the client side, the server thread's
+// decode, and the drain into the lanes
+static void benchSocketIngest(void) {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/bench_socket_%d.sock", (int)getpid());
+    Transport transport;
+    if (!openTransport(&transport, TRANSPORT_SOCKET, path, false)) return;
+    int fd = connectVehicleSocket(path);
+    if (fd < 0) {
+        closeTransport(&transport);
+        return;
+    }
+    Vehicle* vehicles = (Vehicle*)malloc(sizeof(Vehicle) * SOCKET_BATCH_MAX);
+
+    for (size_t b = 0; vehicles && b < sizeof(INGEST_BATCHES) / sizeof(INGEST_BATCHES[0]); b++) {
+        JunctionConfig config;
+        defaultJunctionConfig(&config);
+        config.queueCapacity = 2048;
+        Junction* junction = createJunction(&config);
+        if (!junction) break;
+        Rng rng;
+        seedRng(&rng, BENCH_SEED, RNG_STREAM_GENERATOR);
+        int batch = INGEST_BATCHES[b];
+        long polls = INGEST_BENCH_RECORDS / scaleDivisor / batch;
+        long ingested = 0;
+        BenchRun run;
+
+        beginBench(&run, junction->pool);
+        pauseBench(&run);
+        for (long p = 0; p < polls; p++) {
+            for (int i = 0; i < batch; i++) buildVehicle(&vehicles[i], &rng);
+            resumeBench(&run);
+            if (!sendVehicleBatch(fd, vehicles, batch)) break;
+            for (int got = 0; got < batch; ) {
+                got += pollTransport(&transport, junction->queues, junction->pool, 0);
+                if (got == 0) sched_yield();
+            }
+            ingested += batch;
+            pauseBench(&run);
+            drainJunction(junction);
+        }
+        char params[64];
+        snprintf(params, sizeof(params), "\"transport\":\"socket\",\"batch\":%d,", batch);
+        reportBench(&run, junction->pool, "ingest", params, "record", ingested);
+        destroyJunction(junction);
+    }
+    free(vehicles);
+    close(fd);
+    closeTransport(&transport);
+}
+
+#ifdef BENCH_RENDER
+// Software renderer into an off-screen surface: no window or display needed
+static void benchRender(void) {
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : NULL;
+    if (!renderer) {
+        fprintf(stderr, "Render bench skipped: %s\n", SDL_GetError());
+        if (surface) SDL_FreeSurface(surface);
+        return;
+    }
+    TrafficLight lights[4] = {
+        {310, 370, false, "t1"}, {310, 210, false, "t2"},
+        {470, 210, false, "t3"}, {470, 370, false, "t4"}
+    };
+
+    for (size_t d = 0; d < sizeof(TICK_DENSITIES) / sizeof(TICK_DENSITIES[0]); d++) {
+        Junction* junction = createJunction(NULL);
+        if (!junction) break;
+        Rng rng;
+        seedRng(&rng, BENCH_SEED, RNG_STREAM_GENERATOR);
+        topUpLanes(junction, &rng, TICK_DENSITIES[d]);
+        SceneCache scene;
+        initSceneCache(&scene);
+        Snapshot snapshot;
+        if (!initSnapshot(&snapshot, junction->pool->capacity)) {
+            destroyJunction(junction);
+            break;
+        }
+        long frames = RENDER_BENCH_FRAMES / scaleDivisor;
+        BenchRun run;
+
+        beginBench(&run, junction->pool);
+        for (long f = 0; f < frames; f++) {
+            drawStaticScene(renderer, &scene);
+            drawTrafficLights(renderer, lights);
+            captureSnapshot(&snapshot, junction);
+            drawVehicles(renderer, &scene, &snapshot, 1.0f);
+            SDL_RenderPresent(renderer);
+        }
+        pauseBench(&run);
+        char params[32];
+        snprintf(params, sizeof(params), "\"density\":%d,", TICK_DENSITIES[d]);
+        reportBench(&run, junction->pool, "render_frame", params, "frame", frames);
+        destroySnapshot(&snapshot);
+        destroySceneCache(&scene);
+        destroyJunction(junction);
+    }
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+}
+#endif
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -q, --quick         Run a tenth of the default iterations\n"
+        "  -o, --only NAME     Run one group: queue, tick, ingest or render\n"
+        "  -h, --help          Show this help\n",
+        program);
+}
+
+int main(int argc, char* argv[]) {
+    const char* only = NULL;
+    static struct option options[] = {
+        {"quick", no_argument, 0, 'q'},
+        {"only", required_argument, 0, 'o'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "qo:h", options, NULL)) != -1) {
+        switch (opt) {
+            case 'q': scaleDivisor = 10; break;
+            case 'o': only = optarg; break;
+            case 'h': printUsage(argv[0]); return 0;
+            default: printUsage(argv[0]); return 1;
+        }
+    }
+
+    if (!only || strcmp(only, "queue") == 0) benchQueueOps();
+    if (!only || strcmp(only, "tick") == 0) benchTicks();
+    if (!only || strcmp(only, "ingest") == 0) {
+        benchFileIngest();
+        benchRingIngest();
+        benchSocketIngest();
+    }
+#ifdef BENCH_RENDER
+    if (!only || strcmp(only, "render") == 0) benchRender();
+#endif
+    return 0;
+}
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "checkpoint.h"
+
+#define INDEX_CHUNK 256
+
+static uint64_t checkpointSize(const CheckpointHeader* header) {
+    uint64_t queued = 0;
+    for (int i = 0; i < NUM_QUEUES; i++) queued += (uint64_t)header->queues[i].size;
+    return sizeof(CheckpointHeader) + 2 * sizeof(DelayHistogram) +
+           (uint64_t)header->poolCapacity * (sizeof(Vehicle) + 2 * sizeof(int)) +
+           queued * sizeof(int) + (uint64_t)header->emergencyCount * sizeof(EmergencyEntry) +
+           NUM_QUEUES * sizeof(long);
+}
+
+static bool writeAll(int fd, const void* data, size_t length) {
+    const char* p = (const char*)data;
+    while (length > 0) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static void fillHeader(const Junction* junction, CheckpointHeader* header) {
+    memset(header, 0, sizeof(*header)); // Padding too, so equal states give equal files
+    header->magic = CHECKPOINT_MAGIC;
+    header->version = CHECKPOINT_VERSION;
+    header->headerSize = sizeof(CheckpointHeader);
+    header->vehicleSize = sizeof(Vehicle);
+    header->configSize = sizeof(JunctionConfig);
+    header->config = junction->config;
+    memcpy(header->roadRng, junction->roadRng, sizeof(header->roadRng));
+    header->controllerState = junction->controllerState;
+    memcpy(header->lightStates, junction->lightStates, sizeof(header->lightStates));
+    header->currentLight = junction->currentLight;
+    header->lightTimer = junction->lightTimer;
+    header->vehicleGenTimer = junction->vehicleGenTimer;
+    header->tick = junction->tick;
+    header->vehiclesIngested = junction->vehiclesIngested;
+    header->vehiclesSpawned = junction->vehiclesSpawned;
+    header->vehiclesExited = junction->vehiclesExited;
+    header->conflictsAvoided = junction->conflictsAvoided;
+
+    const VehiclePool* pool = junction->pool;
+    header->poolCapacity = pool->capacity;
+    header->poolFreeCount = pool->freeCount;
+    header->poolInUse = pool->inUse;
+    header->poolHighWater = pool->highWater;
+    header->poolAllocations = pool->allocations;
+    header->poolExhausted = pool->exhausted;
+
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        const Queue* queue = junction->queues[i];
+        CheckpointQueue* saved = &header->queues[i];
+        saved->capacity = queue->capacity;
+        saved->size = queue->size;
+        saved->waitingTime = queue->waitingTime;
+        saved->isPriorityLane = queue->isPriorityLane;
+        saved->drops = queue->drops;
+        saved->backpressured = queue->backpressured;
+        saved->grows = queue->grows;
+        saved->enqueued = queue->enqueued;
+    }
+
+    const Preemption* emergencies = junction->emergencies;
+    header->emergencyCount = emergencies->count;
+    header->emergenciesDetected = emergencies->detected;
+    header->emergenciesCleared = emergencies->cleared;
+    header->preemptions = emergencies->preemptions;
+    header->fileSize = checkpointSize(header);
+}
+
+// Written to PATH.tmp and renamed, so a reader never sees half a checkpoint
+bool writeCheckpoint(const Junction* junction, const char* path) {
+    char temp[PATH_MAX];
+    size_t length = strlen(path);
+    if (length + 5 > sizeof(temp)) return false;
+    memcpy(temp, path, length);
+    memcpy(temp + length, ".tmp", 5);
+
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    CheckpointHeader header;
+    fillHeader(junction, &header);
+    const VehiclePool* pool = junction->pool;
+    const Preemption* emergencies = junction->emergencies;
+    bool ok = writeAll(fd, &header, sizeof(header)) &&
+              writeAll(fd, &junction->waitStats, sizeof(DelayHistogram)) &&
+              writeAll(fd, &emergencies->latency, sizeof(DelayHistogram)) &&
+              writeAll(fd, pool->slots, sizeof(Vehicle) * pool->capacity) &&
+              writeAll(fd, pool->freeList, sizeof(int) * pool->capacity);
+
+    int indices[INDEX_CHUNK];
+    for (int i = 0; ok && i < NUM_QUEUES; i++) {
+        Queue* queue = junction->queues[i];
+        for (int j = 0; ok && j < queue->size; j += INDEX_CHUNK) {
+            int n = queue->size - j < INDEX_CHUNK ? queue->size - j : INDEX_CHUNK;
+            for (int k = 0; k < n; k++) indices[k] = vehiclePoolIndex(pool, queueAt(queue, j + k));
+            ok = writeAll(fd, indices, sizeof(int) * n);
+        }
+    }
+    ok = ok && writeAll(fd, emergencies->heap, sizeof(EmergencyEntry) * emergencies->count) &&
+         writeAll(fd, emergencies->position, sizeof(int) * emergencies->poolCapacity) &&
+         writeAll(fd, emergencies->seenEnqueued, sizeof(long) * emergencies->queueCount);
+
+    if (close(fd) != 0) ok = false;
+    if (ok) ok = rename(temp, path) == 0;
+    if (!ok) unlink(temp);
+    return ok;
+}
+
+// fork() gives the child a copy-on-write image of the whole junction; the
+// parent only pays for the page-table copy and for pages it dirties while
+// the child is still writing
+pid_t forkCheckpoint(const Junction* junction, const char* path) {
+    fflush(NULL); // Buffered output must not be written twice
+    pid_t pid = fork();
+    if (pid == 0) _exit(writeCheckpoint(junction, path) ? 0 : 1);
+    return pid;
+}
+
+bool waitCheckpoint(pid_t pid) {
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Bounds-checked reads from the mapping
+typedef struct {
+    const uint8_t* data;
+    size_t offset;
+    size_t size;
+} CheckpointCursor;
+
+static const void* take(CheckpointCursor* cursor, size_t length) {
+    if (length > cursor->size - cursor->offset) return NULL;
+    const void* p = cursor->data + cursor->offset;
+    cursor->offset += length;
+    return p;
+}
+
+static bool restoreQueue(Junction* junction, int index, const CheckpointQueue* saved, CheckpointCursor* cursor) {
+    Queue* queue = junction->queues[index];
+    if (saved->capacity != queue->capacity) {
+        Queue* resized = createQueueWithCapacity(queue->direction, queue->lane, saved->capacity, queue->overflowPolicy);
+        if (!resized || resized->capacity < saved->size) {
+            if (resized) destroyQueue(resized);
+            return false;
+        }
+        destroyQueue(queue);
+        junction->queues[index] = queue = resized;
+    }
+    const int* indices = (const int*)take(cursor, sizeof(int) * saved->size);
+    if (!indices) return false;
+    for (int j = 0; j < saved->size; j++) {
+        int slot;
+        memcpy(&slot, &indices[j], sizeof(slot));
+        if (slot < 0 || slot >= junction->pool->capacity) return false;
+        queue->items[j] = &junction->pool->slots[slot];
+    }
+    queue->front = 0;
+    queue->rear = saved->size - 1;
+    queue->size = saved->size;
+    queue->waitingTime = saved->waitingTime;
+    queue->isPriorityLane = saved->isPriorityLane;
+    queue->drops = saved->drops;
+    queue->backpressured = saved->backpressured;
+    queue->grows = saved->grows;
+    queue->enqueued = saved->enqueued;
+    return true;
+}
+
+static bool restoreSections(Junction* junction, const CheckpointHeader* header, CheckpointCursor* cursor) {
+    VehiclePool* pool = junction->pool;
+    Preemption* emergencies = junction->emergencies;
+    const void* p;
+
+    if (!(p = take(cursor, sizeof(DelayHistogram)))) return false;
+    memcpy(&junction->waitStats, p, sizeof(DelayHistogram));
+    if (!(p = take(cursor, sizeof(DelayHistogram)))) return false;
+    memcpy(&emergencies->latency, p, sizeof(DelayHistogram));
+    if (!(p = take(cursor, sizeof(Vehicle) * pool->capacity))) return false;
+    memcpy(pool->slots, p, sizeof(Vehicle) * pool->capacity);
+    if (!(p = take(cursor, sizeof(int) * pool->capacity))) return false;
+    memcpy(pool->freeList, p, sizeof(int) * pool->capacity);
+    pool->freeCount = header->poolFreeCount;
+    pool->inUse = header->poolInUse;
+    pool->highWater = header->poolHighWater;
+    pool->allocations = header->poolAllocations;
+    pool->exhausted = header->poolExhausted;
+
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        if (!restoreQueue(junction, i, &header->queues[i], cursor)) return false;
+    }
+
+    if (!(p = take(cursor, sizeof(EmergencyEntry) * header->emergencyCount))) return false;
+    memcpy(emergencies->heap, p, sizeof(EmergencyEntry) * header->emergencyCount);
+    emergencies->count = header->emergencyCount;
+    if (!(p = take(cursor, sizeof(int) * emergencies->poolCapacity))) return false;
+    memcpy(emergencies->position, p, sizeof(int) * emergencies->poolCapacity);
+    if (!(p = take(cursor, sizeof(long) * emergencies->queueCount))) return false;
+    memcpy(emergencies->seenEnqueued, p, sizeof(long) * emergencies->queueCount);
+    emergencies->detected = header->emergenciesDetected;
+    emergencies->cleared = header->emergenciesCleared;
+    emergencies->preemptions = header->preemptions;
+    return true;
+}
+
+void applyRestoreOverrides(Junction* junction, const JunctionConfig* config, bool seedGiven, bool controllerGiven) {
+    if (seedGiven) {
+        junction->config.seed = config->seed;
+        for (int dir = 0; dir < 4; dir++) seedRng(&junction->roadRng[dir], config->seed, RNG_STREAM_ROAD(dir));
+    }
+    if (controllerGiven) {
+        junction->config.controller = config->controller;
+        junction->signal = signalController(config->controller);
+        junction->controllerState.priorityActive = false; // Hysteresis belongs to the old controller
+        junction->controllerState.priorityYield = 0;
+    }
+    if (config->preemption) junction->config.preemption = true;
+    if (!config->spawner) junction->config.spawner = false;
+}
+
+// Maps the file read-only and copies each section straight out of the
+// mapping into a freshly created junction
+Junction* restoreJunction(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CheckpointHeader)) {
+        close(fd);
+        return NULL;
+    }
+    void* mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) return NULL;
+    madvise(mem, st.st_size, MADV_SEQUENTIAL);
+
+    CheckpointHeader header;
+    memcpy(&header, mem, sizeof(header));
+    Junction* junction = NULL;
+    if (header.magic != CHECKPOINT_MAGIC || header.version != CHECKPOINT_VERSION ||
+        header.headerSize != sizeof(CheckpointHeader) || header.vehicleSize != sizeof(Vehicle) ||
+        header.configSize != sizeof(JunctionConfig) || header.poolCapacity != VEHICLE_POOL_CAPACITY ||
+        header.emergencyCount < 0 || header.emergencyCount > header.poolCapacity ||
+        header.fileSize != (uint64_t)st.st_size || checkpointSize(&header) != header.fileSize) {
+        fprintf(stderr, "%s is not a version %d checkpoint from this build\n", path, CHECKPOINT_VERSION);
+        munmap(mem, st.st_size);
+        return NULL;
+    }
+
+    junction = createJunction(&header.config);
+    if (junction) {
+        memcpy(junction->roadRng, header.roadRng, sizeof(header.roadRng));
+        junction->controllerState = header.controllerState;
+        memcpy(junction->lightStates, header.lightStates, sizeof(header.lightStates));
+        junction->currentLight = header.currentLight;
+        junction->lightTimer = header.lightTimer;
+        junction->vehicleGenTimer = header.vehicleGenTimer;
+        junction->tick = header.tick;
+        junction->vehiclesIngested = header.vehiclesIngested;
+        junction->vehiclesSpawned = header.vehiclesSpawned;
+        junction->vehiclesExited = header.vehiclesExited;
+        junction->conflictsAvoided = header.conflictsAvoided;
+
+        CheckpointCursor cursor = {(const uint8_t*)mem, sizeof(header), (size_t)st.st_size};
+        if (!restoreSections(junction, &header, &cursor)) {
+            fprintf(stderr, "%s is corrupt\n", path);
+            // The queues may point into a half-restored pool; drop them unfreed
+            for (int i = 0; i < NUM_QUEUES; i++) junction->queues[i]->size = 0;
+            destroyJunction(junction);
+            junction = NULL;
+        }
+    }
+    munmap(mem, st.st_size);
+    return junction;
+}
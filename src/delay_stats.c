@@ -0,0 +1,38 @@
+#include "delay_stats.h"
+
+void recordDelay(DelayHistogram* histogram, double delayMs) {
+    if (delayMs < 0) delayMs = 0;
+    int bin = (int)(delayMs / DELAY_BIN_MS);
+    if (bin >= DELAY_BINS) bin = DELAY_BINS - 1;
+    histogram->bins[bin]++;
+    histogram->count++;
+    histogram->totalMs += delayMs;
+    if (delayMs > histogram->maxMs) histogram->maxMs = delayMs;
+}
+
+void mergeDelayHistogram(DelayHistogram* into, const DelayHistogram* from) {
+    for (int i = 0; i < DELAY_BINS; i++) into->bins[i] += from->bins[i];
+    into->count += from->count;
+    into->totalMs += from->totalMs;
+    if (from->maxMs > into->maxMs) into->maxMs = from->maxMs;
+}
+
+double meanDelay(const DelayHistogram* histogram) {
+    return histogram->count ? histogram->totalMs / histogram->count : 0.0;
+}
+
+// Upper edge of the bin holding the given percentile (0-100), capped at the max seen
+double delayPercentile(const DelayHistogram* histogram, double percentile) {
+    if (histogram->count == 0) return 0.0;
+    uint64_t rank = (uint64_t)(percentile / 100.0 * histogram->count);
+    if (rank >= histogram->count) rank = histogram->count - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < DELAY_BINS; i++) {
+        seen += histogram->bins[i];
+        if (seen > rank) {
+            double edge = (i + 1) * (double)DELAY_BIN_MS;
+            return edge < histogram->maxMs ? edge : histogram->maxMs;
+        }
+    }
+    return histogram->maxMs;
+}
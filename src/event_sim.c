@@ -0,0 +1,300 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "event_sim.h"
+#include "traffic_generator.h"
+#include "trace.h"
+
+
+static bool eventBefore(const SimEvent* a, const SimEvent* b) {
+    return a->timeMs < b->timeMs || (a->timeMs == b->timeMs && a->seq < b->seq);
+}
+
+bool pushEvent(EventHeap* heap, double timeMs, EventType type, int queueIndex, int vehicle) {
+    if (heap->count == heap->capacity) {
+        int capacity = heap->capacity ? heap->capacity * 2 : EVENT_HEAP_INITIAL;
+        SimEvent* events = (SimEvent*)realloc(heap->events, capacity * sizeof(SimEvent));
+        if (!events) return false;
+        heap->events = events;
+        heap->capacity = capacity;
+    }
+    SimEvent event = {timeMs, heap->nextSeq++, (uint8_t)type, (uint8_t)queueIndex, vehicle};
+    int i = heap->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!eventBefore(&event, &heap->events[parent])) break;
+        heap->events[i] = heap->events[parent];
+        i = parent;
+    }
+    heap->events[i] = event;
+    return true;
+}
+
+bool popEvent(EventHeap* heap, SimEvent* event) {
+    if (heap->count == 0) return false;
+    *event = heap->events[0];
+    SimEvent last = heap->events[--heap->count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && eventBefore(&heap->events[child + 1], &heap->events[child])) child++;
+        if (!eventBefore(&heap->events[child], &last)) break;
+        heap->events[i] = heap->events[child];
+        i = child;
+    }
+    if (heap->count > 0) heap->events[i] = last;
+    return true;
+}
+
+// Distances along the direction of travel, in pixels; same stop lines as the lane store
+static void approachDistances(const Vehicle* vehicle, float* toStop, float* toExit) {
+    switch (vehicle->startDirection) {
+        case DIRECTION_SOUTH: // A - moves up from the bottom
+            *toStop = vehicle->y - (WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2 + 5);
+            *toExit = vehicle->y + VEHICLE_SIZE;
+            break;
+        case DIRECTION_WEST:  // B - moves left from the right
+            *toStop = vehicle->x - (WINDOW_WIDTH / 2 + ROAD_WIDTH / 2 + 5);
+            *toExit = vehicle->x + VEHICLE_SIZE;
+            break;
+        case DIRECTION_EAST:  // C - moves right from the left
+            *toStop = (WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 - 5) - vehicle->x;
+            *toExit = WINDOW_WIDTH + VEHICLE_SIZE - vehicle->x;
+            break;
+        default:              // D - moves down from the top
+            *toStop = (WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 - 5) - vehicle->y;
+            *toExit = WINDOW_HEIGHT + VEHICLE_SIZE - vehicle->y;
+            break;
+    }
+    if (*toStop < 0) *toStop = 0;
+    if (*toExit < *toStop) *toExit = *toStop;
+}
+
+static double spawnPeriodMs(const Junction* junction) {
+    return (double)junction->config.spawnIntervalTicks * SIM_TICK_MS;
+}
+
+// A replayed trace is polled exactly when its next record is due; a record
+// already due was refused for lack of room and is retried after EVENT_POLL_MS
+static double nextPollMs(const EventSim* sim) {
+    if (sim->transport->kind != TRANSPORT_REPLAY) return sim->nowMs + EVENT_POLL_MS;
+    double next = nextReplayMs(sim->transport->replay);
+    return next > sim->nowMs ? next : sim->nowMs + EVENT_POLL_MS;
+}
+
+// Fixed-time controllers only change phase on cycle boundaries; adaptive ones
+// are asked every CONTROLLER_DECISION_MS
+static double lightPeriodMs(const Junction* junction) {
+    return junction->signal->adaptive ? CONTROLLER_DECISION_MS : junction->config.lightCycleMs;
+}
+
+static double travelMs(float distance, float speed) {
+    return distance / (speed > 0 ? speed : 1.0f) * SIM_TICK_MS;
+}
+
+// Time between successive departures from one lane
+static double headwayMs(const Vehicle* vehicle) {
+    return travelMs(VEHICLE_SIZE + SAFE_DISTANCE, vehicle->speed);
+}
+
+// Every scheduling helper below returns false once the heap cannot grow; the
+// simulation is then incomplete and runEventSim stops
+static bool scheduleCheck(EventSim* sim, int queueIndex, double timeMs) {
+    if (sim->checkPending[queueIndex] && sim->checkAtMs[queueIndex] <= timeMs) return true;
+    if (!pushEvent(&sim->heap, timeMs, EVENT_LANE_CHECK, queueIndex, -1)) return false;
+    sim->checkPending[queueIndex] = true;
+    sim->checkAtMs[queueIndex] = timeMs;
+    return true;
+}
+
+static void snapshotSizes(const Junction* junction, int sizes[NUM_QUEUES]) {
+    for (int i = 0; i < NUM_QUEUES; i++) sizes[i] = junction->queues[i]->size;
+}
+
+// Brings the lights up to date and wakes the lanes that just turned green
+static bool refreshLights(EventSim* sim) {
+    Junction* junction = sim->junction;
+    int sizes[NUM_QUEUES];
+    snapshotSizes(junction, sizes);
+    long phaseChanges = junction->controllerState.phaseChanges;
+    updateLights(junction, (int)((long)sim->nowMs - sim->lightsAtMs), sizes);
+    sim->lightsAtMs = (long)sim->nowMs;
+    if (junction->controllerState.phaseChanges == phaseChanges) return true;
+    for (int dir = 0; dir < 4; dir++) {
+        if (lightForDirection(dir) != junction->currentLight) continue;
+        for (int lane = 0; lane < 3; lane++) {
+            if (!scheduleCheck(sim, dir * 3 + lane, sim->nowMs)) return false;
+        }
+    }
+    return true;
+}
+
+// Preemption reacts as soon as the longest-waiting emergency vehicle changes,
+// not at the next controller decision
+static bool refreshPreemption(EventSim* sim, int preemptedBefore) {
+    Junction* junction = sim->junction;
+    if (!junction->config.preemption || preemptedQueue(junction->emergencies) == preemptedBefore) return true;
+    return refreshLights(sim);
+}
+
+// Stamps stop-line arrival times on vehicles enqueued since sizesBefore was taken
+static bool admitNewVehicles(EventSim* sim, const int sizesBefore[NUM_QUEUES]) {
+    Junction* junction = sim->junction;
+    int preempted = preemptedQueue(junction->emergencies);
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        Queue* queue = junction->queues[i];
+        for (int k = sizesBefore[i]; k < queue->size; k++) {
+            Vehicle* vehicle = queueAt(queue, k);
+            float toStop, toExit;
+            approachDistances(vehicle, &toStop, &toExit);
+            double arrival = sim->nowMs + travelMs(toStop, vehicle->speed);
+            sim->stopLineMs[vehiclePoolIndex(junction->pool, vehicle)] = arrival;
+            if (k == 0 && !scheduleCheck(sim, i, arrival)) return false;
+        }
+    }
+    detectEmergencies(junction->emergencies, junction->queues, junction->pool, junction->tick);
+    return refreshPreemption(sim, preempted);
+}
+
+// Lets the front vehicle cross if it has reached the stop line, the lane has
+// cleared the previous departure and the light allows it
+static bool checkLane(EventSim* sim, int queueIndex) {
+    Junction* junction = sim->junction;
+    Queue* queue = junction->queues[queueIndex];
+    if (isEmpty(queue)) return true;
+    Vehicle* vehicle = peekFront(queue);
+    int index = vehiclePoolIndex(junction->pool, vehicle);
+
+    double arrival = sim->stopLineMs[index];
+    if (arrival > sim->nowMs) return scheduleCheck(sim, queueIndex, arrival);
+    double ready = sim->lastDepartMs[queueIndex] + headwayMs(vehicle);
+    if (ready > sim->nowMs) return scheduleCheck(sim, queueIndex, ready);
+    if (!canProceedThroughIntersection(vehicle, junction->lightStates)) return true; // Next green re-checks
+
+    // The exit is scheduled first, so a vehicle only departs once it is sure to leave
+    float toStop, toExit;
+    approachDistances(vehicle, &toStop, &toExit);
+    if (!pushEvent(&sim->heap, sim->nowMs + travelMs(toExit - toStop, vehicle->speed), EVENT_EXIT, queueIndex, index)) {
+        return false;
+    }
+    dequeue(queue);
+    vehicle->waitTime = (int)((sim->nowMs - arrival) / SIM_TICK_MS);
+    vehicle->passedIntersection = true;
+    sim->lastDepartMs[queueIndex] = sim->nowMs;
+    sim->inFlight[queueIndex / 3]++;
+    return isEmpty(queue) || scheduleCheck(sim, queueIndex, sim->nowMs + headwayMs(vehicle));
+}
+
+static bool exitVehicle(EventSim* sim, int queueIndex, int index) {
+    Junction* junction = sim->junction;
+    int preempted = preemptedQueue(junction->emergencies);
+    sim->inFlight[queueIndex / 3]--;
+    Vehicle* vehicle = &junction->pool->slots[index];
+    finishTrip(junction, vehicle);
+    freeVehicle(junction->pool, vehicle);
+    junction->vehiclesExited++;
+    return refreshPreemption(sim, preempted);
+}
+
+EventSim* createEventSim(Junction* junction, Transport* transport) {
+    EventSim* sim = (EventSim*)calloc(1, sizeof(EventSim));
+    if (!sim) return NULL;
+    sim->junction = junction;
+    sim->transport = transport;
+    sim->stopLineMs = (double*)calloc(junction->pool->capacity, sizeof(double));
+    if (!sim->stopLineMs) {
+        destroyEventSim(sim);
+        return NULL;
+    }
+    for (int i = 0; i < NUM_QUEUES; i++) sim->lastDepartMs[i] = -1e18;
+
+    int empty[NUM_QUEUES] = {0};
+    bool ok = admitNewVehicles(sim, empty); // Anything already queued
+    ok = ok && pushEvent(&sim->heap, lightPeriodMs(junction), EVENT_LIGHT, 0, -1);
+    if (ok && junction->config.spawner) ok = pushEvent(&sim->heap, spawnPeriodMs(junction), EVENT_SPAWN, 0, -1);
+    if (ok && transport && transport->kind != TRANSPORT_NONE) ok = pushEvent(&sim->heap, 0, EVENT_POLL, 0, -1);
+    if (!ok) {
+        destroyEventSim(sim);
+        return NULL;
+    }
+    return sim;
+}
+
+// recordStranded for the event engine, whose queued vehicles only get a
+// waitTime when they depart: the wait so far runs from their stop-line arrival
+int recordEventStranded(const EventSim* sim, DelayHistogram* stranded) {
+    const Junction* junction = sim->junction;
+    int count = 0;
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        Queue* queue = junction->queues[i];
+        for (int j = 0; j < queue->size; j++) {
+            double arrival = sim->stopLineMs[vehiclePoolIndex(junction->pool, queueAt(queue, j))];
+            recordDelay(stranded, arrival < sim->nowMs ? sim->nowMs - arrival : 0.0);
+            count++;
+        }
+    }
+    return count;
+}
+
+void destroyEventSim(EventSim* sim) {
+    if (!sim) return;
+    free(sim->heap.events);
+    free(sim->stopLineMs);
+    free(sim);
+}
+
+// Processes every event up to and including untilMs. Returns false, with the
+// run cut short, if the event heap could not grow; a lost exit or lane check
+// would otherwise leave vehicles stranded in the pool.
+bool runEventSim(EventSim* sim, double untilMs) {
+    TRACE_SCOPE("run_events");
+    Junction* junction = sim->junction;
+    SimEvent event;
+    int sizes[NUM_QUEUES];
+    bool ok = true;
+
+    while (ok && sim->heap.count > 0 && sim->heap.events[0].timeMs <= untilMs) {
+        popEvent(&sim->heap, &event);
+        sim->nowMs = event.timeMs;
+        junction->tick = (long)(sim->nowMs / SIM_TICK_MS);
+        sim->eventsProcessed++;
+
+        switch (event.type) {
+            case EVENT_SPAWN: {
+                int queueLengths[4];
+                for (int dir = 0; dir < 4; dir++) queueLengths[dir] = sim->inFlight[dir];
+                for (int i = 0; i < NUM_QUEUES; i++) queueLengths[i / 3] += junction->queues[i]->size;
+                snapshotSizes(junction, sizes);
+                spawnVehicles(junction, queueLengths);
+                ok = admitNewVehicles(sim, sizes) &&
+                     pushEvent(&sim->heap, sim->nowMs + spawnPeriodMs(junction), EVENT_SPAWN, 0, -1);
+                break;
+            }
+            case EVENT_POLL: {
+                snapshotSizes(junction, sizes);
+                junction->vehiclesIngested += pollTransport(sim->transport, junction->queues, junction->pool, sim->nowMs);
+                double next = nextPollMs(sim);
+                ok = admitNewVehicles(sim, sizes) &&
+                     (next == INFINITY || pushEvent(&sim->heap, next, EVENT_POLL, 0, -1));
+                break;
+            }
+            case EVENT_LIGHT:
+                ok = refreshLights(sim) &&
+                     pushEvent(&sim->heap, sim->nowMs + lightPeriodMs(junction), EVENT_LIGHT, 0, -1);
+                break;
+            case EVENT_LANE_CHECK:
+                if (!sim->checkPending[event.queueIndex] || sim->checkAtMs[event.queueIndex] != event.timeMs) break;
+                sim->checkPending[event.queueIndex] = false;
+                ok = checkLane(sim, event.queueIndex);
+                break;
+            case EVENT_EXIT:
+                ok = exitVehicle(sim, event.queueIndex, event.vehicle);
+                break;
+        }
+    }
+    if (!ok) return false;
+    sim->nowMs = untilMs;
+    junction->tick = (long)(untilMs / SIM_TICK_MS);
+    return true;
+}
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include "file_ingest.h"
+#include "transport.h"
+#include "trace.h"
+
+#define WATCH_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM)
+
+static void closeWatchedFile(FileIngest* ingest) {
+    if (ingest->fd >= 0) close(ingest->fd);
+    ingest->fd = -1;
+    ingest->offset = 0;
+    ingest->carry = 0;
+}
+
+// Blocks (off the simulation thread) until the ring has room or we are stopping
+static bool pushVehicle(FileIngest* ingest, const Vehicle* vehicle) {
+    Vehicle* slot;
+    while (!(slot = reserveVehicleSlot(ingest->ring))) {
+        if (atomic_load_explicit(&ingest->stopping, memory_order_relaxed)) return false;
+        atomic_fetch_add_explicit(&ingest->ringFull, 1, memory_order_relaxed);
+        struct timespec wait = {0, 1000000};
+        nanosleep(&wait, NULL);
+    }
+    *slot = *vehicle;
+    publishVehicleSlot(ingest->ring);
+    return true;
+}
+
+// Parses every complete line in buffer[0, length) and keeps the unfinished
+// tail for the next read
+static bool parseLines(FileIngest* ingest, int length) {
+    char* start = ingest->buffer;
+    char* end = ingest->buffer + length;
+    char* newline;
+    while ((newline = memchr(start, '\n', end - start))) {
+        *newline = '\0';
+        Vehicle vehicle;
+        if (!parseVehicleLine(start, &vehicle)) {
+            if (newline > start) atomic_fetch_add_explicit(&ingest->malformed, 1, memory_order_relaxed);
+        } else {
+            if (!pushVehicle(ingest, &vehicle)) return false;
+            atomic_fetch_add_explicit(&ingest->parsed, 1, memory_order_relaxed);
+        }
+        start = newline + 1;
+    }
+    ingest->carry = (int)(end - start);
+    if (ingest->carry >= FILE_INGEST_MAX_LINE) { // No newline in sight: not a record
+        atomic_fetch_add_explicit(&ingest->malformed, 1, memory_order_relaxed);
+        ingest->carry = 0;
+    }
+    memmove(ingest->buffer, start, ingest->carry);
+    return true;
+}
+
+// Consumes whatever was appended since the last call
+static void readAppended(FileIngest* ingest) {
+    TRACE_SCOPE("file_ingest");
+    // A different file under the watched name (deleted and recreated, or
+    // renamed over it) starts from its beginning
+    struct stat st, named;
+    if (ingest->fd >= 0 && (fstat(ingest->fd, &st) != 0 || st.st_nlink == 0 || stat(ingest->path, &named) != 0 ||
+                            st.st_ino != named.st_ino || st.st_dev != named.st_dev)) {
+        closeWatchedFile(ingest);
+    }
+    if (ingest->fd < 0) {
+        ingest->fd = open(ingest->path, O_RDONLY | O_CLOEXEC);
+        if (ingest->fd < 0 || fstat(ingest->fd, &st) != 0) {
+            closeWatchedFile(ingest);
+            return;
+        }
+    }
+    if (st.st_size < ingest->offset) {
+        atomic_fetch_add_explicit(&ingest->truncations, 1, memory_order_relaxed);
+        ingest->offset = 0;
+        ingest->carry = 0;
+    }
+
+    for (;;) {
+        ssize_t n = pread(ingest->fd, ingest->buffer + ingest->carry, FILE_INGEST_CHUNK, ingest->offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        ingest->offset += n;
+        if (!parseLines(ingest, ingest->carry + (int)n)) return;
+    }
+}
+
+// Collects inotify events; returns whether the watched file may have new bytes
+static bool drainWatchEvents(FileIngest* ingest) {
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    ssize_t n;
+    while ((n = read(ingest->inotifyFd, events, sizeof(events))) > 0) {
+        for (char* p = events; p < events + n; ) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->len > 0 && strcmp(event->name, ingest->name) == 0) changed = true;
+        }
+    }
+    return changed;
+}
+
+static void* ingestMain(void* arg) {
+    FileIngest* ingest = (FileIngest*)arg;
+    readAppended(ingest); // Whatever was written since the open
+    struct pollfd fds[2] = {
+        {ingest->inotifyFd, POLLIN, 0},
+        {ingest->stopFd, POLLIN, 0}
+    };
+    while (!atomic_load_explicit(&ingest->stopping, memory_order_relaxed)) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        atomic_fetch_add_explicit(&ingest->wakeups, 1, memory_order_relaxed);
+        if (drainWatchEvents(ingest)) readAppended(ingest);
+    }
+    return NULL;
+}
+
+FileIngest* openFileIngest(const char* path, bool fromStart) {
+    FileIngest* ingest = (FileIngest*)calloc(1, sizeof(FileIngest));
+    if (!ingest) return NULL;
+    ingest->fd = -1;
+    ingest->inotifyFd = -1;
+    ingest->stopFd = -1;
+    snprintf(ingest->path, sizeof(ingest->path), "%s", path);
+
+    // Watch the directory rather than the file, so the file may be created,
+    // replaced or deleted while we run
+    char directory[sizeof(ingest->path)];
+    char* slash = strrchr(ingest->path, '/');
+    if (slash) {
+        snprintf(directory, sizeof(directory), "%.*s", (int)(slash - ingest->path), ingest->path);
+        if (directory[0] == '\0') snprintf(directory, sizeof(directory), "/");
+        ingest->name = slash + 1;
+    } else {
+        snprintf(directory, sizeof(directory), ".");
+        ingest->name = ingest->path;
+    }
+
+    ingest->ring = createLocalVehicleRing(FILE_INGEST_RING_CAPACITY);
+    ingest->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    ingest->stopFd = eventfd(0, EFD_CLOEXEC);
+    if (!ingest->ring || ingest->inotifyFd < 0 || ingest->stopFd < 0 ||
+        inotify_add_watch(ingest->inotifyFd, directory, WATCH_EVENTS) < 0) {
+        perror(ingest->path);
+        closeFileIngest(ingest);
+        return NULL;
+    }
+    if (!fromStart) {
+        struct stat st;
+        ingest->fd = open(ingest->path, O_RDONLY | O_CLOEXEC);
+        if (ingest->fd >= 0 && fstat(ingest->fd, &st) == 0) ingest->offset = st.st_size;
+        else closeWatchedFile(ingest); // Not there yet: it will be read from the start once created
+    }
+    atomic_init(&ingest->stopping, false);
+    if (pthread_create(&ingest->thread, NULL, ingestMain, ingest) != 0) {
+        closeFileIngest(ingest);
+        return NULL;
+    }
+    ingest->threadStarted = true;
+    return ingest;
+}
+
+void closeFileIngest(FileIngest* ingest) {
+    if (!ingest) return;
+    if (ingest->threadStarted) {
+        atomic_store(&ingest->stopping, true);
+        uint64_t one = 1;
+        if (write(ingest->stopFd, &one, sizeof(one)) < 0) perror("file ingest stop");
+        pthread_join(ingest->thread, NULL);
+    }
+    closeWatchedFile(ingest);
+    if (ingest->inotifyFd >= 0) close(ingest->inotifyFd);
+    if (ingest->stopFd >= 0) close(ingest->stopFd);
+    closeVehicleRing(ingest->ring);
+    free(ingest);
+}
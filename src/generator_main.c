@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "traffic_generator.h"
+#include "transport.h"
+#include "arrival_generator.h"
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [--transport file|shm|socket] [--seed N] [--batch N] [PATH_OR_NAME]\n"
+        "  file    append text records to PATH (default vehicles.txt)\n"
+        "  shm     push records into the shared-memory ring NAME (default %s)\n"
+        "  socket  stream batches to the simulator listening on PATH (default %s);\n"
+        "          any number of generators may connect at once\n"
+        "  --seed N   reproduce an earlier run's traffic (default: from the clock)\n"
+        "  --batch N  vehicles per socket batch and interval (default 1, at most %d)\n"
+        "Poisson mode (any of these options enables it):\n"
+        "  --rate R[,R...]      vehicles/second: one total split over the 8 approach lanes,\n"
+        "                       or 8 values for A-L1, A-L2, B-L1, ... D-L2 (peak-hour rates with a profile)\n"
+        "  --profile P          scale rates by a 24-hour demand curve: \"default\" or a file of 24 values\n"
+        "  --profile-period S   wall seconds per simulated day (default 86400)\n"
+        "  --start-hour H       hour of the profile to start at (default 0)\n"
+        "  --duration S         stop after S seconds (default: run until killed)\n",
+        program, VEHICLE_RING_NAME, SOCKET_INGEST_PATH, SOCKET_BATCH_MAX);
+}
+
+int main(int argc, char* argv[]) {
+    TransportKind kind = TRANSPORT_FILE;
+    const char* path = NULL;
+    uint64_t seed = rngSeedFromClock();
+    int batch = 1;
+    ArrivalConfig arrivals;
+    defaultArrivalConfig(&arrivals);
+    bool poisson = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--transport") == 0 && i + 1 < argc) {
+            kind = parseTransportKind(argv[++i]);
+            // A replay trace is written by trace_convert, not streamed
+            if (kind != TRANSPORT_FILE && kind != TRANSPORT_SHM && kind != TRANSPORT_SOCKET) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = parseSeed(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch = atoi(argv[++i]);
+            if (batch < 1 || batch > SOCKET_BATCH_MAX) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            if (!parseArrivalRates(&arrivals, argv[++i])) {
+                fprintf(stderr, "--rate takes one total or %d per-lane rates\n", ARRIVAL_STREAMS);
+                return 1;
+            }
+            poisson = true;
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            if (!loadArrivalProfile(&arrivals, argv[++i])) return 1;
+            poisson = true;
+        } else if (strcmp(argv[i], "--profile-period") == 0 && i + 1 < argc) {
+            arrivals.periodSeconds = atof(argv[++i]);
+            poisson = true;
+        } else if (strcmp(argv[i], "--start-hour") == 0 && i + 1 < argc) {
+            arrivals.startHour = atof(argv[++i]);
+            poisson = true;
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            arrivals.durationSeconds = atof(argv[++i]);
+            poisson = true;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    if (poisson) {
+        if (arrivals.periodSeconds <= 0 || arrivals.startHour < 0 || arrivals.startHour >= ARRIVAL_PROFILE_HOURS) {
+            fprintf(stderr, "The profile period must be positive and the start hour in [0, 24)\n");
+            return 1;
+        }
+        arrivals.seed = seed;
+        return startArrivalGeneration(&arrivals, kind, path) ? 0 : 1;
+    }
+
+    if (kind == TRANSPORT_SHM) {
+        VehicleRing* ring = openVehicleRing(path ? path : VEHICLE_RING_NAME, VEHICLE_RING_CAPACITY);
+        if (!ring) {
+            fprintf(stderr, "Could not open shared-memory ring %s\n", path ? path : VEHICLE_RING_NAME);
+            return 1;
+        }
+        startVehicleGenerationToRing(ring, seed);
+        closeVehicleRing(ring);
+    } else if (kind == TRANSPORT_SOCKET) {
+        startVehicleGenerationToSocket(path ? path : SOCKET_INGEST_PATH, seed, batch);
+    } else {
+        startVehicleGeneration(path ? path : "vehicles.txt", seed);
+    }
+    return 0;
+}
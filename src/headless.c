@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <time.h>
+#include <errno.h>
+#include <math.h>
+#include "junction.h"
+#include "lane_store.h"
+#include "event_sim.h"
+#include "trace.h"
+#include "checkpoint.h"
+
+#define DEFAULT_TICKS 100000
+#define RUN_CHUNK_TICKS 64   // Between end-of-replay checks when running until the trace is done
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Paces --realtime runs against absolute deadlines, so slow steps do not add up to drift
+static void sleepUntilMs(const struct timespec* start, double offsetMs) {
+    long long ns = (long long)(offsetMs * 1e6);
+    struct timespec deadline = {start->tv_sec + (time_t)(ns / 1000000000LL), start->tv_nsec + (long)(ns % 1000000000LL)};
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {}
+}
+
+// Nothing left anywhere: no trace records, queued or in-flight vehicles
+static bool replayDrained(const Transport* transport, const Junction* junction, const VehicleStore* store) {
+    if (nextReplayMs(transport->replay) < INFINITY || junction->pool->inUse > 0) return false;
+    for (int i = 0; store && i < NUM_QUEUES; i++) {
+        if (store->lanes[i].count > 0) return false;
+    }
+    return true;
+}
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -t, --ticks N       Number of simulation ticks to run (default %d)\n"
+        "  -s, --seconds S     Simulated seconds to run (overrides --ticks)\n"
+        "  -f, --file PATH     Also ingest vehicles from PATH every tick\n"
+        "      --transport K   Ingest through transport K (file, shm or socket)\n"
+        "      --source S      File path, shared-memory name or socket path for the transport\n"
+        "      --from-start    File transport: also ingest what the file already holds, not just\n"
+        "                      lines appended after the start\n"
+        "      --replay TRACE  Inject a binary arrival trace (see trace_convert) at its recorded\n"
+        "                      times instead of spawning; runs until it is done unless -t/-s is given\n"
+        "      --realtime      Pace the run to the wall clock instead of running flat out\n"
+        "      --engine E      queue (default), soa (per-lane structure-of-arrays store)\n"
+        "                      or event (discrete-event: jumps between arrivals, phases, departures)\n"
+        "      --queue-capacity N   Initial lane capacity, rounded up to a power of two\n"
+        "      --overflow P    Full-lane policy: reject (default), grow or backpressure\n"
+        "      --seed N        Seed for the built-in spawner (default: from the clock)\n"
+        "      --light-cycle-ms N   Green time per phase (default %d)\n"
+        "      --spawn-interval N   Ticks between built-in spawn rounds (default %d)\n"
+        "      --emergency-percent N   Share of spawns that are emergency vehicles (default %d)\n"
+        "      --spawn-limit N      Built-in spawner skips roads with N vehicles queued (default %d)\n"
+        "      --controller C  Signal controller: fixed (default), actuated, max-pressure or priority\n"
+        "                      (AL2 priority only kicks in with --spawn-limit above 10)\n"
+        "      --preempt       Give an emergency vehicle's road the green until it has left (queue and\n"
+        "                      event engines)\n"
+        "      --journey-log PATH   Append a binary record for every completed trip\n"
+        "      --checkpoint PATH    Save the full junction state to PATH at the end of the run\n"
+        "      --checkpoint-at S    Save it S simulated seconds in instead, from a forked child,\n"
+        "                           while the run carries on\n"
+        "      --restore PATH       Start from a saved junction (queue engine); --seed, --controller\n"
+        "                           and --preempt override the saved values for a what-if run\n"
+        "  -h, --help          Show this help\n",
+        program, DEFAULT_TICKS, LIGHT_CYCLE_TIME, VEHICLE_GEN_INTERVAL, EMERGENCY_PERCENT, SPAWN_QUEUE_LIMIT);
+}
+
+int main(int argc, char* argv[]) {
+    long ticks = DEFAULT_TICKS;
+    TransportKind transportKind = TRANSPORT_NONE;
+    const char* source = NULL;
+    const char* journeyPath = NULL;
+    bool useStore = false;
+    bool useEvents = false;
+    bool ticksGiven = false;
+    bool realtime = false;
+    bool fromStart = false;
+    const char* checkpointPath = NULL;
+    const char* restorePath = NULL;
+    long checkpointTick = -1;
+    bool seedGiven = false;
+    bool controllerGiven = false;
+    JunctionConfig config;
+    defaultJunctionConfig(&config);
+
+    static struct option options[] = {
+        {"ticks", required_argument, 0, 't'},
+        {"seconds", required_argument, 0, 's'},
+        {"file", required_argument, 0, 'f'},
+        {"transport", required_argument, 0, 'T'},
+        {"source", required_argument, 0, 'S'},
+        {"from-start", no_argument, 0, 'F'},
+        {"engine", required_argument, 0, 'E'},
+        {"queue-capacity", required_argument, 0, 'Q'},
+        {"overflow", required_argument, 0, 'O'},
+        {"seed", required_argument, 0, 'R'},
+        {"journey-log", required_argument, 0, 'J'},
+        {"light-cycle-ms", required_argument, 0, 'L'},
+        {"spawn-interval", required_argument, 0, 'I'},
+        {"emergency-percent", required_argument, 0, 'M'},
+        {"spawn-limit", required_argument, 0, 'P'},
+        {"controller", required_argument, 0, 'C'},
+        {"preempt", no_argument, 0, 'X'},
+        {"replay", required_argument, 0, 'Y'},
+        {"realtime", no_argument, 0, 'W'},
+        {"checkpoint", required_argument, 0, 'K'},
+        {"checkpoint-at", required_argument, 0, 'A'},
+        {"restore", required_argument, 0, 'Z'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "t:s:f:h", options, NULL)) != -1) {
+        switch (opt) {
+            case 't': ticks = atol(optarg); ticksGiven = true; break;
+            case 's': ticks = (long)(atof(optarg) * 1000.0 / SIM_TICK_MS); ticksGiven = true; break;
+            case 'f': transportKind = TRANSPORT_FILE; source = optarg; break;
+            case 'T':
+                transportKind = parseTransportKind(optarg);
+                if (transportKind == TRANSPORT_COUNT) { printUsage(argv[0]); return 1; }
+                break;
+            case 'S': source = optarg; break;
+            case 'F': fromStart = true; break;
+            case 'Q': config.queueCapacity = atoi(optarg); break;
+            case 'O': config.overflowPolicy = parseOverflowPolicy(optarg); break;
+            case 'R': config.seed = parseSeed(optarg); seedGiven = true; break;
+            case 'J': journeyPath = optarg; break;
+            case 'L': config.lightCycleMs = atoi(optarg); break;
+            case 'I': config.spawnIntervalTicks = atoi(optarg); break;
+            case 'M': config.emergencyPercent = atoi(optarg); break;
+            case 'P': config.spawnQueueLimit = atoi(optarg); break;
+            case 'X': config.preemption = true; break;
+            case 'Y': transportKind = TRANSPORT_REPLAY; source = optarg; break;
+            case 'W': realtime = true; break;
+            case 'K': checkpointPath = optarg; break;
+            case 'A': checkpointTick = (long)(atof(optarg) * 1000.0 / SIM_TICK_MS); break;
+            case 'Z': restorePath = optarg; break;
+            case 'C':
+                config.controller = parseControllerKind(optarg);
+                if (config.controller == CONTROLLER_COUNT) { printUsage(argv[0]); return 1; }
+                controllerGiven = true;
+                break;
+            case 'E':
+                if (strcmp(optarg, "soa") == 0) useStore = true;
+                else if (strcmp(optarg, "event") == 0) useEvents = true;
+                else if (strcmp(optarg, "queue") != 0) { printUsage(argv[0]); return 1; }
+                break;
+            case 'h': printUsage(argv[0]); return 0;
+            default: printUsage(argv[0]); return 1;
+        }
+    }
+    if (transportKind == TRANSPORT_REPLAY) config.spawner = false; // The trace is the only source of traffic
+    if (ticks <= 0) {
+        fprintf(stderr, "Tick count must be positive\n");
+        return 1;
+    }
+    if (config.lightCycleMs <= 0 || config.spawnIntervalTicks <= 0) {
+        fprintf(stderr, "Light cycle and spawn interval must be positive\n");
+        return 1;
+    }
+    if (config.preemption && useStore) {
+        fprintf(stderr, "The soa engine does not track individual vehicles; use --engine queue or event\n");
+        return 1;
+    }
+
+    if ((checkpointPath || restorePath) && (useStore || useEvents)) {
+        fprintf(stderr, "Checkpoints save the queue engine's state; use --engine queue\n");
+        return 1;
+    }
+    if (checkpointTick >= 0 && !checkpointPath) {
+        fprintf(stderr, "--checkpoint-at needs --checkpoint PATH\n");
+        return 1;
+    }
+
+    if (transportKind == TRANSPORT_FILE && !source) source = "vehicles.txt";
+    Transport transport;
+    if (!openTransport(&transport, transportKind, source, fromStart)) return 1;
+
+    Junction* junction = restorePath ? restoreJunction(restorePath) : createJunction(&config);
+    if (!junction) {
+        if (restorePath) fprintf(stderr, "Restoring %s failed\n", restorePath);
+        else fprintf(stderr, "Junction creation failed\n");
+        closeTransport(&transport);
+        return 1;
+    }
+    long restoredTick = junction->tick;
+    if (restorePath) {
+        applyRestoreOverrides(junction, &config, seedGiven, controllerGiven);
+        config = junction->config;
+    }
+
+    VehicleStore* store = NULL;
+    if (useStore && !(store = createVehicleStore(LANE_STORE_CAPACITY))) {
+        fprintf(stderr, "Vehicle store creation failed\n");
+        destroyJunction(junction);
+        closeTransport(&transport);
+        return 1;
+    }
+    EventSim* events = NULL;
+    if (useEvents && !(events = createEventSim(junction, &transport))) {
+        fprintf(stderr, "Event engine creation failed\n");
+        destroyJunction(junction);
+        closeTransport(&transport);
+        return 1;
+    }
+
+    JourneyLog* journeyLog = NULL;
+    if (journeyPath && !(journeyLog = openJourneyLog(journeyPath, SIM_TICK_MS))) {
+        perror(journeyPath);
+        destroyEventSim(events);
+        destroyVehicleStore(store);
+        destroyJunction(junction);
+        closeTransport(&transport);
+        return 1;
+    }
+    junction->journeyLog = journeyLog;
+
+    TRACE_INIT(TRACE_DEFAULT_PATH);
+    double start = nowSeconds();
+    struct timespec startTime;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    bool untilDrained = transportKind == TRANSPORT_REPLAY && !ticksGiven;
+    long t = 0;
+    pid_t writer = -1;
+    double forkMs = 0.0;
+    bool engineOk = true;
+    for (;;) {
+        if (t == checkpointTick) {
+            double before = nowSeconds();
+            writer = forkCheckpoint(junction, checkpointPath);
+            forkMs = (nowSeconds() - before) * 1000.0;
+            if (writer < 0) perror("fork");
+        }
+        if (untilDrained ? replayDrained(&transport, junction, store) : t >= ticks) break;
+        // Real time advances a tick per frame; otherwise run as far as possible at once
+        long end = t + (realtime ? 1 : untilDrained ? RUN_CHUNK_TICKS : ticks - t);
+        if (!untilDrained && end > ticks) end = ticks;
+        if (t < checkpointTick && end > checkpointTick) end = checkpointTick;
+        if (events && !runEventSim(events, (double)end * SIM_TICK_MS)) {
+            fprintf(stderr, "Event heap allocation failed; stopping after %.1f simulated seconds\n",
+                events->nowMs / 1000.0);
+            engineOk = false;
+            break;
+        }
+        for (; !events && t < end; t++) {
+            TRACE_POLL();
+            if (store) stepVehicleStore(store, junction, &transport);
+            else stepJunction(junction, &transport);
+        }
+        t = end;
+        if (realtime) sleepUntilMs(&startTime, (double)t * SIM_TICK_MS);
+    }
+    ticks = t;
+    double elapsed = nowSeconds() - start;
+
+    bool checkpointOk = true;
+    if (checkpointPath && checkpointTick < 0) {
+        checkpointOk = writeCheckpoint(junction, checkpointPath);
+    } else if (checkpointPath) {
+        checkpointOk = writer >= 0 && waitCheckpoint(writer);
+    }
+
+    // Vehicles that never got to cross count against the controller too
+    static DelayHistogram stranded;
+    int strandedCount = events ? recordEventStranded(events, &stranded) :
+                        store ? recordStoreStranded(store, &stranded) : recordStranded(junction, &stranded);
+
+    double simSeconds = ticks * (SIM_TICK_MS / 1000.0);
+    printf("seed:               %llu\n", (unsigned long long)config.seed);
+    printf("controller:         %s\n", junction->signal->name);
+    printf("ticks:              %ld\n", ticks);
+    if (restorePath) printf("restored from:      %s at tick %ld\n", restorePath, restoredTick);
+    printf("simulated seconds:  %.1f\n", simSeconds);
+    printf("wall seconds:       %.3f\n", elapsed);
+    printf("ticks/sec:          %.0f\n", elapsed > 0 ? ticks / elapsed : 0.0);
+    printf("speedup:            %.1fx\n", elapsed > 0 ? simSeconds / elapsed : 0.0);
+    printf("vehicles spawned:   %ld\n", junction->vehiclesSpawned);
+    printf("vehicles ingested:  %ld\n", junction->vehiclesIngested);
+    printf("vehicles processed: %ld\n", junction->vehiclesExited);
+    printf("conflicts avoided:  %ld\n", junction->conflictsAvoided);
+    printf("phase changes:      %ld\n", junction->controllerState.phaseChanges);
+    printf("wait mean/p95/max:  %.1f / %.1f / %.1f s\n", meanDelay(&junction->waitStats) / 1000.0,
+        delayPercentile(&junction->waitStats, 95) / 1000.0, junction->waitStats.maxMs / 1000.0);
+    printf("stranded:           %d still waiting to cross, waited mean/max %.1f / %.1f s so far\n",
+        strandedCount, meanDelay(&stranded) / 1000.0, stranded.maxMs / 1000.0);
+    const Preemption* emergencies = junction->emergencies;
+    printf("emergency vehicles: %ld detected, %ld cleared, %ld preemptions\n",
+        emergencies->detected, emergencies->cleared, emergencies->preemptions);
+    printf("emergency latency mean/p95/max: %.1f / %.1f / %.1f s\n", meanDelay(&emergencies->latency) / 1000.0,
+        delayPercentile(&emergencies->latency, 95) / 1000.0, emergencies->latency.maxMs / 1000.0);
+    printf("pool high-water:    %d / %d\n", junction->pool->highWater, junction->pool->capacity);
+    printf("pool exhausted:     %ld\n", junction->pool->exhausted);
+    long backpressured = 0, grows = 0;
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        backpressured += junction->queues[i]->backpressured;
+        grows += junction->queues[i]->grows;
+    }
+    printf("queue drops:        %ld\n", countQueueDrops(junction));
+    printf("queue backpressure: %ld\n", backpressured);
+    printf("queue grows:        %ld\n", grows);
+    if (events) printf("events processed:   %ld\n", events->eventsProcessed);
+    if (transport.server) printSocketClients(transport.server, stdout);
+    if (transport.replay) {
+        printf("replayed:           %ld injected, %ld rejected, %ld out of order, %s\n",
+            transport.replay->injected, transport.replay->rejected, transport.replay->outOfOrder,
+            nextReplayMs(transport.replay) < INFINITY ? "trace not finished" : "trace finished");
+    }
+
+    if (checkpointPath && checkpointTick >= 0) {
+        if (checkpointTick > ticks) printf("checkpoint:         not written, the run ended before tick %ld\n", checkpointTick);
+        else printf("checkpoint:         %s at tick %ld (fork %.2f ms) %s\n", checkpointPath,
+            restoredTick + checkpointTick, forkMs, checkpointOk ? "written" : "FAILED");
+    } else if (checkpointPath) {
+        printf("checkpoint:         %s at tick %ld %s\n", checkpointPath, junction->tick,
+            checkpointOk ? "written" : "FAILED");
+    }
+
+    if (journeyLog) {
+        printf("journeys logged:    %ld (dropped %ld)\n", journeyLog->logged, journeyLog->dropped);
+        closeJourneyLog(journeyLog);
+    }
+    TRACE_SHUTDOWN();
+    destroyEventSim(events);
+    destroyVehicleStore(store);
+    destroyJunction(junction);
+    closeTransport(&transport);
+    return checkpointOk && engineOk ? 0 : 1;
+}
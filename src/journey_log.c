@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include "journey_log.h"
+
+#define JOURNEY_IDLE_SLEEP_NS 1000000L
+
+static bool writeAll(int fd, const void* data, size_t size) {
+    const char* p = (const char*)data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+static double monotonicMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Writes the pending records straight out of the ring, at most two spans
+static void flushPending(JourneyLog* log, uint64_t tail, uint64_t head) {
+    uint64_t index = tail & (JOURNEY_RING_CAPACITY - 1);
+    uint64_t count = head - tail;
+    uint64_t first = JOURNEY_RING_CAPACITY - index;
+    if (first > count) first = count;
+
+    bool ok = writeAll(log->fd, &log->records[index], first * sizeof(JourneyRecord));
+    if (ok && count > first) ok = writeAll(log->fd, &log->records[0], (count - first) * sizeof(JourneyRecord));
+    if (!ok) log->writeFailed = true;
+    else atomic_fetch_add_explicit(&log->written, (long)count, memory_order_relaxed);
+    atomic_store_explicit(&log->tail, head, memory_order_release);
+}
+
+static void* journeyWriterMain(void* arg) {
+    JourneyLog* log = (JourneyLog*)arg;
+    double lastFlush = monotonicMs();
+    struct timespec idle = {0, JOURNEY_IDLE_SLEEP_NS};
+
+    for (;;) {
+        bool stopping = atomic_load_explicit(&log->stopping, memory_order_acquire);
+        uint64_t head = atomic_load_explicit(&log->head, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&log->tail, memory_order_relaxed);
+        uint64_t pending = head - tail;
+
+        if (pending >= JOURNEY_FLUSH_BATCH || (pending > 0 && (stopping || monotonicMs() - lastFlush >= JOURNEY_FLUSH_MS))) {
+            flushPending(log, tail, head);
+            lastFlush = monotonicMs();
+            continue;
+        }
+        if (stopping) break;
+        nanosleep(&idle, NULL);
+    }
+    return NULL;
+}
+
+JourneyLog* openJourneyLog(const char* path, uint32_t tickMs) {
+    JourneyLog* log = (JourneyLog*)aligned_alloc(CACHE_LINE_SIZE, sizeof(JourneyLog));
+    if (!log) return NULL;
+    memset(log, 0, sizeof(*log));
+
+    log->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log->fd < 0) {
+        free(log);
+        return NULL;
+    }
+    JourneyHeader header = {JOURNEY_MAGIC, JOURNEY_VERSION, sizeof(JourneyRecord), tickMs, 0};
+    if (!writeAll(log->fd, &header, sizeof(header)) ||
+        pthread_create(&log->writer, NULL, journeyWriterMain, log) != 0) {
+        close(log->fd);
+        free(log);
+        return NULL;
+    }
+    return log;
+}
+
+// Simulation thread only. Never blocks: a full ring drops the record.
+bool logJourney(JourneyLog* log, const JourneyRecord* record) {
+    uint64_t head = atomic_load_explicit(&log->head, memory_order_relaxed);
+    if (head - log->cachedTail >= JOURNEY_RING_CAPACITY) {
+        log->cachedTail = atomic_load_explicit(&log->tail, memory_order_acquire);
+        if (head - log->cachedTail >= JOURNEY_RING_CAPACITY) {
+            log->dropped++;
+            return false;
+        }
+    }
+    log->records[head & (JOURNEY_RING_CAPACITY - 1)] = *record;
+    atomic_store_explicit(&log->head, head + 1, memory_order_release);
+    log->logged++;
+    return true;
+}
+
+void closeJourneyLog(JourneyLog* log) {
+    if (!log) return;
+    atomic_store_explicit(&log->stopping, true, memory_order_release);
+    pthread_join(log->writer, NULL);
+    if (close(log->fd) != 0) log->writeFailed = true;
+    if (log->writeFailed) fprintf(stderr, "Journey log: write failed, records lost\n");
+    free(log);
+}
@@ -0,0 +1,375 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include "junction.h"
+#include "traffic_generator.h"
+#include "trace.h"
+
+void defaultJunctionConfig(JunctionConfig* config) {
+    config->queueCapacity = DEFAULT_QUEUE_CAPACITY;
+    config->overflowPolicy = QUEUE_OVERFLOW_REJECT;
+    config->seed = rngSeedFromClock();
+    config->lightCycleMs = LIGHT_CYCLE_TIME;
+    config->spawner = true;
+    config->spawnIntervalTicks = VEHICLE_GEN_INTERVAL;
+    config->emergencyPercent = EMERGENCY_PERCENT;
+    config->spawnQueueLimit = SPAWN_QUEUE_LIMIT;
+    config->controller = CONTROLLER_FIXED;
+    config->preemption = false;
+}
+
+// config may be NULL for the defaults
+Junction* createJunction(const JunctionConfig* config) {
+    JunctionConfig defaults;
+    if (!config) {
+        defaultJunctionConfig(&defaults);
+        config = &defaults;
+    }
+    if (config->lightCycleMs <= 0 || config->spawnIntervalTicks <= 0) return NULL;
+    if (!signalController(config->controller)) return NULL;
+
+    Junction* junction = (Junction*)calloc(1, sizeof(Junction));
+    if (!junction) return NULL;
+    junction->config = *config;
+    junction->signal = signalController(config->controller);
+    for (int dir = 0; dir < 4; dir++) seedRng(&junction->roadRng[dir], config->seed, RNG_STREAM_ROAD(dir));
+
+    junction->pool = createVehiclePool(VEHICLE_POOL_CAPACITY);
+    junction->grid = createSpatialGrid(VEHICLE_POOL_CAPACITY);
+    junction->emergencies = createPreemption(VEHICLE_POOL_CAPACITY, NUM_QUEUES);
+    if (!junction->pool || !junction->grid || !junction->emergencies) {
+        destroyJunction(junction);
+        return NULL;
+    }
+
+    for (int dir = 0; dir < 4; dir++) {
+        for (int lane = 0; lane < 3; lane++) {
+            junction->queues[dir * 3 + lane] = createQueueWithCapacity(dir, lane,
+                config->queueCapacity, config->overflowPolicy);
+            if (!junction->queues[dir * 3 + lane]) {
+                destroyJunction(junction);
+                return NULL;
+            }
+        }
+    }
+    // All red initially
+    for (int i = 0; i < NUM_LIGHTS; i++) junction->lightStates[i] = false;
+    junction->currentLight = 0;
+    return junction;
+}
+
+void destroyJunction(Junction* junction) {
+    if (!junction) return;
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        if (!junction->queues[i]) continue;
+        while (!isEmpty(junction->queues[i])) {
+            Vehicle* vehicle = dequeue(junction->queues[i]);
+            if (vehicle) freeVehicle(junction->pool, vehicle);
+        }
+        destroyQueue(junction->queues[i]);
+    }
+    if (junction->pool) destroyVehiclePool(junction->pool);
+    destroySpatialGrid(junction->grid);
+    destroyPreemption(junction->emergencies);
+    free(junction);
+}
+
+long countQueueDrops(const Junction* junction) {
+    long drops = 0;
+    for (int i = 0; i < NUM_QUEUES; i++) drops += junction->queues[i]->drops;
+    return drops;
+}
+
+// Vehicles still short of the stop line when a run ends never reach
+// finishTrip; records the wait each has built up so far and returns how many
+// there are. For the queue engine; the others keep their own vehicles.
+int recordStranded(const Junction* junction, DelayHistogram* stranded) {
+    int count = 0;
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        Queue* queue = junction->queues[i];
+        for (int j = 0; j < queue->size; j++) {
+            const Vehicle* vehicle = queueAt(queue, j);
+            if (vehicle->passedIntersection) continue;
+            recordDelay(stranded, (double)vehicle->waitTime * SIM_TICK_MS);
+            count++;
+        }
+    }
+    return count;
+}
+
+void spawnVehicles(Junction* junction, int queueLengths[4]) {
+    for (int dir = 0; dir < 4; dir++) {
+        if (queueLengths[dir] < junction->config.spawnQueueLimit) {
+            Rng* rng = &junction->roadRng[dir];
+            int lane = rngRange(rng, 2); // Lane 0 (Left) or Lane 1 (Center)
+            Vehicle* vehicle = allocVehicle(junction->pool);
+            if (vehicle) {
+                vehicle->vehicleId = (int)(rngNext(rng) & 0x7fffffff);
+                vehicle->type = ((int)rngRange(rng, 100) < 100 - junction->config.emergencyPercent) ? 0 : (1 + rngRange(rng, 3));
+                vehicle->startDirection = dir;
+                vehicle->startLane = lane;
+                vehicle->speed = 2.0f + rngRange(rng, 15) / 10.0f; // Faster speed
+                float laneOffset;
+                if (dir == 2 || dir == 3) { 
+                    laneOffset = ((2 - lane) + 0.5) * LANE_WIDTH;
+                } else {
+                    laneOffset = (lane + 0.5) * LANE_WIDTH;
+                }
+                switch(dir) {
+                    case 0: // A (Southbound)
+                        vehicle->x = WINDOW_WIDTH/2 - ROAD_WIDTH/2 + laneOffset;
+                        vehicle->y = WINDOW_HEIGHT + VEHICLE_SIZE;
+                        break;
+                    case 1: // B (Westbound)
+                        vehicle->x = WINDOW_WIDTH + VEHICLE_SIZE;
+                        vehicle->y = WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + laneOffset;
+                        break;
+                    case 2: // C (Eastbound)
+                        vehicle->x = -VEHICLE_SIZE;
+                        vehicle->y = WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + laneOffset;
+                        break;
+                    case 3: // D (Northbound)
+                        vehicle->x = WINDOW_WIDTH/2 - ROAD_WIDTH/2 + laneOffset;
+                        vehicle->y = -VEHICLE_SIZE;
+                        break;
+                }
+                vehicle->turning = false;
+                vehicle->turnAngle = 0.0f;
+                vehicle->progress = 0.0f;
+                vehicle->waitTime = 0;
+                vehicle->passedIntersection = false;
+                setVehiclePath(vehicle, rng);
+                if (enqueue(junction->queues[dir * 3 + lane], vehicle) == ENQUEUE_OK) {
+                    junction->vehiclesSpawned++;
+                } else {
+                    freeVehicle(junction->pool, vehicle);
+                }
+            }
+        }
+    }
+}
+
+static void switchLight(Junction* junction, int light) {
+    junction->lightTimer = 0;
+    junction->lightStates[junction->currentLight] = false;
+    junction->currentLight = light;
+    junction->lightStates[light] = true;
+    junction->controllerState.phaseChanges++;
+}
+
+// While any emergency vehicle is in the junction, the road of the one detected
+// first stays green; everything ahead of it in its lane drains with it. The
+// controller is bypassed until the last one leaves.
+static bool preemptEmergency(Junction* junction) {
+    int queueIndex = preemptedQueue(junction->emergencies);
+    if (queueIndex < 0) return false;
+    int light = lightForDirection(queueIndex / 3);
+    if (light != junction->currentLight || !junction->lightStates[light]) {
+        switchLight(junction, light);
+        junction->emergencies->preemptions++;
+    }
+    return true;
+}
+
+// Asks the junction's controller whether to change phase. laneSizes is the
+// number of vehicles in each lane as the calling engine counts them.
+void updateLights(Junction* junction, int elapsedMs, const int laneSizes[NUM_QUEUES]) {
+    junction->lightTimer += elapsedMs;
+    if (junction->config.preemption && preemptEmergency(junction)) return;
+    SignalInput input = {
+        junction->currentLight, junction->lightStates[junction->currentLight],
+        junction->lightTimer, junction->config.lightCycleMs, laneSizes
+    };
+    int next = junction->signal->choosePhase(&input, &junction->controllerState);
+    if (next < 0 || next >= NUM_LIGHTS || (next == junction->currentLight && input.green)) return;
+    switchLight(junction, next);
+}
+
+// Every engine reports vehicles leaving the junction here
+void finishTrip(Junction* junction, const Vehicle* vehicle) {
+    if (vehicle->type > 0) {
+        clearEmergency(junction->emergencies, vehiclePoolIndex(junction->pool, vehicle), junction->tick, SIM_TICK_MS);
+    }
+    if (junction->onExit && junction->onExit(junction->exitContext, vehicle)) return;
+    recordDelay(&junction->waitStats, (double)vehicle->waitTime * SIM_TICK_MS);
+    if (junction->journeyLog) {
+        JourneyRecord record = {
+            (uint32_t)junction->tick, (uint32_t)vehicle->vehicleId, (uint32_t)vehicle->waitTime,
+            (uint8_t)vehicle->type,
+            encodeJourneyRoute(vehicle->startDirection, vehicle->startLane,
+                               vehicle->endDirection, vehicle->endLane), 0
+        };
+        logJourney(junction->journeyLog, &record);
+    }
+}
+
+bool isInsideIntersection(const Vehicle* vehicle) {
+    return fabsf(vehicle->x - WINDOW_WIDTH / 2) < ROAD_WIDTH / 2 &&
+           fabsf(vehicle->y - WINDOW_HEIGHT / 2) < ROAD_WIDTH / 2;
+}
+
+// Close enough to the box that a vehicle inside it could be in the way
+bool isNearIntersection(float x, float y) {
+    return fabsf(x - WINDOW_WIDTH / 2) < ROAD_WIDTH / 2 + SAFE_DISTANCE &&
+           fabsf(y - WINDOW_HEIGHT / 2) < ROAD_WIDTH / 2 + SAFE_DISTANCE;
+}
+
+// Where updateVehiclePosition would put the vehicle this tick
+static void predictPosition(const Vehicle* vehicle, float* x, float* y) {
+    *x = vehicle->x;
+    *y = vehicle->y;
+    if (vehicle->turning && vehicle->progress < 1.0f) return;
+    switch (vehicle->startDirection) {
+        case DIRECTION_SOUTH: *y -= vehicle->speed; break; // A
+        case DIRECTION_WEST:  *x -= vehicle->speed; break; // B
+        case DIRECTION_EAST:  *x += vehicle->speed; break; // C
+        case DIRECTION_NORTH: *y += vehicle->speed; break; // D
+    }
+}
+
+int updateVehiclePositions(Junction* junction) {
+    Queue** queues = junction->queues;
+    bool* lightStates = junction->lightStates;
+    int exited = 0;
+
+    // Vehicles from other lanes are found through the grid rather than by
+    // testing every pair; positions are as of the start of the tick.
+    rebuildSpatialGrid(junction->grid, queues, NUM_QUEUES);
+
+    for (int i = 0; i < 12; i++) {
+        Queue* queue = queues[i];
+        if (isEmpty(queue)) continue;
+        int direction = i / 3; // 0=A, 1=B, 2=C, 3=D
+        int lane = i % 3;
+
+        for (int j = 0; j < queue->size; j++) {
+            Vehicle* vehicle = queueAt(queue, j);
+            if (!vehicle) continue;
+            vehicle->prevX = vehicle->x;
+            vehicle->prevY = vehicle->y;
+
+            // Determine lane offset
+            float laneOffset;
+            if (direction == 1 || direction == 3) {
+                laneOffset = ((2 - lane) + 0.5) * LANE_WIDTH;
+            } else {
+                laneOffset = (lane + 0.5) * LANE_WIDTH;
+            }
+
+            // Set vehicle position based on direction
+            switch (direction) {
+                case 0: vehicle->x = WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 + laneOffset; break; // A
+                case 1: vehicle->y = WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 + laneOffset; break; // B
+                case 2: vehicle->y = WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 + laneOffset; break; // C
+                case 3: vehicle->x = WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 + laneOffset; break; // D
+            }
+
+            // Check if vehicle is at the zebra crossing
+            bool atZebra = false, pastIntersection = false;
+            switch (direction) {
+                case 0: // A (Southbound)
+                    atZebra = vehicle->y >= WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2 - 40 && vehicle->y < WINDOW_HEIGHT / 2;
+                    break;
+                case 1: // B (Westbound)
+                    atZebra = vehicle->x >= WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 - 40 && vehicle->x < WINDOW_WIDTH / 2;
+                    break;
+                case 2: // C (Eastbound)
+                    atZebra = vehicle->x <= WINDOW_WIDTH / 2 + ROAD_WIDTH / 2 + 40 && vehicle->x > WINDOW_WIDTH / 2;
+                    pastIntersection = vehicle->x > WINDOW_WIDTH / 2;
+                    break;
+                case 3: // D (Northbound)
+                    atZebra = vehicle->y <= WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 + 40 && vehicle->y > WINDOW_HEIGHT / 2;
+                    pastIntersection = vehicle->y < WINDOW_HEIGHT / 2;
+                    break;
+            }
+
+            // Determine if the vehicle can proceed through the intersection
+            bool canMove = canProceedThroughIntersection(vehicle, lightStates);
+            Vehicle* ahead = (j > 0) ? queueAt(queue, j - 1) : NULL;
+            if (ahead && !isSafeDistance(vehicle, ahead)) canMove = false;
+
+            // Vehicles entering the box yield to cross traffic already inside it.
+            // Vehicles inside never yield, so the box always drains.
+            if (canMove && !isInsideIntersection(vehicle)) {
+                float nextX, nextY;
+                predictPosition(vehicle, &nextX, &nextY);
+                if (isNearIntersection(nextX, nextY) &&
+                    findConflict(junction->grid, nextX, nextY, i, isInsideIntersection)) {
+                    canMove = false;
+                    junction->conflictsAvoided++;
+                }
+            }
+
+            // Stop at zebra crossing if light is red (unless past intersection or emergency)
+            if (atZebra && !pastIntersection && !canMove) {
+                vehicle->waitTime++;
+                switch (direction) {
+                    case 0: vehicle->y = WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2 + 5; break; // A
+                    case 1: vehicle->x = WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 - 5; break; // B
+                    case 2: vehicle->x = WINDOW_WIDTH / 2 + ROAD_WIDTH / 2 + 5; break; // C
+                    case 3: vehicle->y = WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 - 5; break; // D
+                }
+                continue; // Skip further movement logic
+            }
+
+            // Update vehicle position if allowed to move
+            if (canMove) {
+                updateVehiclePosition(vehicle);
+            } else {
+                vehicle->waitTime++;
+            }
+
+            // Check if the vehicle should be dequeued and moved to the next queue
+            bool shouldDequeue = false;
+            switch (direction) {
+                case 0: shouldDequeue = vehicle->y < -VEHICLE_SIZE; break; // A
+                case 1: shouldDequeue = vehicle->x < -VEHICLE_SIZE; break; // B
+                case 2: shouldDequeue = vehicle->x > WINDOW_WIDTH + VEHICLE_SIZE; break; // C
+                case 3: shouldDequeue = vehicle->y > WINDOW_HEIGHT + VEHICLE_SIZE; break; // D
+            }
+            // Vehicles off the edge of the window have left the junction.
+            // Only the front vehicle can leave a FIFO lane; others exit once they reach the front.
+            if (shouldDequeue && j == 0) {
+                exited++;
+                finishTrip(junction, vehicle);
+                dequeue(queue);
+                freeVehicle(junction->pool, vehicle);
+                j--; // The next vehicle is now at the front
+            }
+        }
+    }
+    return exited;
+}
+
+// One fixed simulation step: ingest, spawn, move, then cycle the lights
+void stepJunction(Junction* junction, Transport* transport) {
+    TRACE_SCOPE("step");
+    int laneSizes[NUM_QUEUES];
+    int queueLengths[4] = {0};
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        laneSizes[i] = getSize(junction->queues[i]);
+        queueLengths[i / 3] += laneSizes[i];
+    }
+
+    if (transport) {
+        TRACE_SCOPE("poll_transport");
+        junction->vehiclesIngested += pollTransport(transport, junction->queues, junction->pool,
+                                                    (double)junction->tick * SIM_TICK_MS);
+    }
+
+    junction->vehicleGenTimer++;
+    if (junction->config.spawner && junction->vehicleGenTimer >= junction->config.spawnIntervalTicks) {
+        TRACE_SCOPE("spawn");
+        junction->vehicleGenTimer = 0;
+        spawnVehicles(junction, queueLengths);
+    }
+    detectEmergencies(junction->emergencies, junction->queues, junction->pool, junction->tick);
+
+    {
+        TRACE_SCOPE("update_positions");
+        junction->vehiclesExited += updateVehiclePositions(junction);
+    }
+    updateLights(junction, SIM_TICK_MS, laneSizes);
+    junction->tick++;
+}
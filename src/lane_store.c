@@ -0,0 +1,368 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "lane_store.h"
+#include "traffic_generator.h"
+#include "trace.h"
+
+static bool initLane(LaneStore* lane, Direction direction, LanePosition position, int capacity) {
+    memset(lane, 0, sizeof(LaneStore));
+    lane->direction = direction;
+    lane->lane = position;
+    lane->capacity = capacity;
+    lane->x = (float*)malloc(capacity * sizeof(float));
+    lane->y = (float*)malloc(capacity * sizeof(float));
+    lane->speed = (float*)malloc(capacity * sizeof(float));
+    lane->progress = (float*)malloc(capacity * sizeof(float));
+    lane->flags = (uint8_t*)malloc(capacity);
+    lane->vehicleId = (int*)malloc(capacity * sizeof(int));
+    lane->type = (uint8_t*)malloc(capacity);
+    lane->endDirection = (uint8_t*)malloc(capacity);
+    lane->endLane = (uint8_t*)malloc(capacity);
+    lane->waitTime = (int*)malloc(capacity * sizeof(int));
+    return lane->x && lane->y && lane->speed && lane->progress && lane->flags &&
+           lane->vehicleId && lane->type && lane->endDirection && lane->endLane &&
+           lane->waitTime;
+}
+
+static void freeLane(LaneStore* lane) {
+    free(lane->x);
+    free(lane->y);
+    free(lane->speed);
+    free(lane->progress);
+    free(lane->flags);
+    free(lane->vehicleId);
+    free(lane->type);
+    free(lane->endDirection);
+    free(lane->endLane);
+    free(lane->waitTime);
+}
+
+VehicleStore* createVehicleStore(int laneCapacity) {
+    VehicleStore* store = (VehicleStore*)calloc(1, sizeof(VehicleStore));
+    if (!store) return NULL;
+    store->nearLane = (int*)malloc(NUM_QUEUES * laneCapacity * sizeof(int));
+    store->nearSlot = (int*)malloc(NUM_QUEUES * laneCapacity * sizeof(int));
+    if (!store->nearLane || !store->nearSlot) {
+        destroyVehicleStore(store);
+        return NULL;
+    }
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        if (!initLane(&store->lanes[i], i / 3, i % 3, laneCapacity)) {
+            destroyVehicleStore(store);
+            return NULL;
+        }
+    }
+    return store;
+}
+
+void destroyVehicleStore(VehicleStore* store) {
+    if (!store) return;
+    for (int i = 0; i < NUM_QUEUES; i++) freeLane(&store->lanes[i]);
+    free(store->nearLane);
+    free(store->nearSlot);
+    free(store);
+}
+
+// Slides live entries back to index 0 once the front has drifted far enough
+static void compactLane(LaneStore* lane) {
+    if (lane->front == 0) return;
+    int n = lane->count, f = lane->front;
+    memmove(lane->x, lane->x + f, n * sizeof(float));
+    memmove(lane->y, lane->y + f, n * sizeof(float));
+    memmove(lane->speed, lane->speed + f, n * sizeof(float));
+    memmove(lane->progress, lane->progress + f, n * sizeof(float));
+    memmove(lane->flags, lane->flags + f, n);
+    memmove(lane->vehicleId, lane->vehicleId + f, n * sizeof(int));
+    memmove(lane->type, lane->type + f, n);
+    memmove(lane->endDirection, lane->endDirection + f, n);
+    memmove(lane->endLane, lane->endLane + f, n);
+    memmove(lane->waitTime, lane->waitTime + f, n * sizeof(int));
+    lane->front = 0;
+}
+
+// Lane centre across the road, matching updateVehiclePositions
+static float laneCenter(Direction direction, LanePosition lane) {
+    float laneOffset;
+    if (direction == DIRECTION_WEST || direction == DIRECTION_NORTH) {
+        laneOffset = ((2 - lane) + 0.5) * LANE_WIDTH;
+    } else {
+        laneOffset = (lane + 0.5) * LANE_WIDTH;
+    }
+    if (direction == DIRECTION_SOUTH || direction == DIRECTION_NORTH) {
+        return WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 + laneOffset;
+    }
+    return WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 + laneOffset;
+}
+
+bool pushLaneVehicle(LaneStore* lane, const Vehicle* vehicle) {
+    if (lane->front + lane->count >= lane->capacity) {
+        if (lane->count >= lane->capacity) return false;
+        compactLane(lane);
+    }
+    int i = lane->front + lane->count;
+    float center = laneCenter(lane->direction, lane->lane);
+    bool vertical = lane->direction == DIRECTION_SOUTH || lane->direction == DIRECTION_NORTH;
+    lane->x[i] = vertical ? center : vehicle->x;
+    lane->y[i] = vertical ? vehicle->y : center;
+    lane->speed[i] = vehicle->speed;
+    lane->progress[i] = vehicle->progress;
+    lane->flags[i] = (vehicle->turning ? LANE_FLAG_TURNING : 0) |
+                     (vehicle->passedIntersection ? LANE_FLAG_PASSED : 0);
+    lane->vehicleId[i] = vehicle->vehicleId;
+    lane->type[i] = (uint8_t)vehicle->type;
+    lane->endDirection[i] = (uint8_t)vehicle->endDirection;
+    lane->endLane[i] = (uint8_t)vehicle->endLane;
+    lane->waitTime[i] = vehicle->waitTime;
+    lane->count++;
+    return true;
+}
+
+// Hands every queued vehicle over to the store and returns the slots to the
+// pool. The queue keeps counting the lane's stored vehicles against its
+// capacity, so --queue-capacity and --overflow apply as in the queue engine;
+// a vehicle the store has no room for is a drop.
+int moveQueuesToStore(VehicleStore* store, Queue* queues[], VehiclePool* pool) {
+    int moved = 0;
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        while (!isEmpty(queues[i])) {
+            Vehicle* vehicle = dequeue(queues[i]);
+            if (!vehicle) continue;
+            if (pushLaneVehicle(&store->lanes[i], vehicle)) moved++;
+            else queues[i]->drops++;
+            freeVehicle(pool, vehicle);
+        }
+        queues[i]->external = store->lanes[i].count;
+    }
+    return moved;
+}
+
+// The lane update works on one coordinate per lane: the axis of travel.
+// sign is +1 when that coordinate grows as the vehicle advances.
+static void laneAxis(const LaneStore* lane, float** pos, float* sign, float* exitLine) {
+    switch (lane->direction) {
+        case DIRECTION_SOUTH: // A - moves up from the bottom
+            *pos = lane->y; *sign = -1.0f;
+            *exitLine = -VEHICLE_SIZE;
+            break;
+        case DIRECTION_WEST:  // B - moves left from the right
+            *pos = lane->x; *sign = -1.0f;
+            *exitLine = -VEHICLE_SIZE;
+            break;
+        case DIRECTION_EAST:  // C - moves right from the left
+            *pos = lane->x; *sign = 1.0f;
+            *exitLine = WINDOW_WIDTH + VEHICLE_SIZE;
+            break;
+        default:              // D - moves down from the top
+            *pos = lane->y; *sign = 1.0f;
+            *exitLine = WINDOW_HEIGHT + VEHICLE_SIZE;
+            break;
+    }
+}
+
+// Rebuilds the parts of a Vehicle the store keeps, for exit reporting
+static void laneVehicle(const LaneStore* lane, int i, Vehicle* vehicle) {
+    memset(vehicle, 0, sizeof(*vehicle));
+    vehicle->vehicleId = lane->vehicleId[i];
+    vehicle->type = lane->type[i];
+    vehicle->startDirection = lane->direction;
+    vehicle->startLane = lane->lane;
+    vehicle->endDirection = lane->endDirection[i];
+    vehicle->endLane = lane->endLane[i];
+    vehicle->x = lane->x[i];
+    vehicle->y = lane->y[i];
+    vehicle->speed = lane->speed[i];
+    vehicle->progress = lane->progress[i];
+    vehicle->turning = (lane->flags[i] & LANE_FLAG_TURNING) != 0;
+    vehicle->passedIntersection = (lane->flags[i] & LANE_FLAG_PASSED) != 0;
+    vehicle->waitTime = lane->waitTime[i];
+}
+
+// Vehicles of any lane that could be inside the box during this tick. A
+// vehicle moves at most its speed per tick, so anything that can reach the box
+// is already near it. Checks read their live positions.
+static void collectNearBox(VehicleStore* store) {
+    store->nearCount = 0;
+    for (int l = 0; l < NUM_QUEUES; l++) {
+        const LaneStore* lane = &store->lanes[l];
+        for (int i = lane->front; i < lane->front + lane->count; i++) {
+            if (!isNearIntersection(lane->x[i], lane->y[i])) continue;
+            store->nearLane[store->nearCount] = l;
+            store->nearSlot[store->nearCount++] = i;
+        }
+    }
+}
+
+// Cross traffic already in the box that a vehicle placed at (x, y) would hit
+static bool boxConflict(const VehicleStore* store, int laneIndex, float x, float y) {
+    Vehicle probe, other;
+    probe.x = x;
+    probe.y = y;
+    for (int k = 0; k < store->nearCount; k++) {
+        if (store->nearLane[k] == laneIndex) continue;
+        const LaneStore* lane = &store->lanes[store->nearLane[k]];
+        other.x = lane->x[store->nearSlot[k]];
+        other.y = lane->y[store->nearSlot[k]];
+        if (isInsideIntersection(&other) && checkCollision(&probe, &other)) return true;
+    }
+    return false;
+}
+
+// The zebra-crossing hold from updateVehiclePositions: true if a held vehicle
+// at (x, y) is parked at *stop instead of waiting where it is
+static bool zebraStop(Direction direction, float x, float y, float* stop) {
+    bool atZebra = false, pastIntersection = false;
+    switch (direction) {
+        case DIRECTION_SOUTH: // A
+            atZebra = y >= WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2 - 40 && y < WINDOW_HEIGHT / 2;
+            *stop = WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2 + 5;
+            break;
+        case DIRECTION_WEST:  // B
+            atZebra = x >= WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 - 40 && x < WINDOW_WIDTH / 2;
+            *stop = WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 - 5;
+            break;
+        case DIRECTION_EAST:  // C
+            atZebra = x <= WINDOW_WIDTH / 2 + ROAD_WIDTH / 2 + 40 && x > WINDOW_WIDTH / 2;
+            pastIntersection = x > WINDOW_WIDTH / 2;
+            *stop = WINDOW_WIDTH / 2 + ROAD_WIDTH / 2 + 5;
+            break;
+        default:              // D
+            atZebra = y <= WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 + 40 && y > WINDOW_HEIGHT / 2;
+            pastIntersection = y < WINDOW_HEIGHT / 2;
+            *stop = WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 - 5;
+            break;
+    }
+    return atZebra && !pastIntersection;
+}
+
+// Advances one lane front to back under the queue engine's rules: a vehicle
+// moves unless the red light, the vehicle ahead or cross traffic in the box
+// holds it, and only a held vehicle adds to its wait. Each decision depends on
+// where the vehicle ahead has just moved to, so the loop is sequential.
+static int updateLane(VehicleStore* store, int laneIndex, Junction* junction) {
+    LaneStore* lane = &store->lanes[laneIndex];
+    int light = lightForDirection(lane->direction);
+    bool green = light >= 0 && junction->lightStates[light];
+    float* pos;
+    float sign, exitLine;
+    laneAxis(lane, &pos, &sign, &exitLine);
+
+    int head = lane->front, end = lane->front + lane->count, exited = 0;
+    for (int i = head; i < end; i++) {
+        bool turning = (lane->flags[i] & LANE_FLAG_TURNING) && lane->progress[i] < 1.0f;
+        bool canMove = green || lane->type[i] == 1 || (lane->flags[i] & LANE_FLAG_PASSED);
+
+        // Same test as isSafeDistance; the two share a lane centre, so only the axis of travel differs
+        if (i > head) {
+            float distance = (float)fabs((double)pos[i - 1] - (double)pos[i]);
+            float required = SAFE_DISTANCE;
+            if (lane->type[i] > 0 || lane->type[i - 1] > 0) required *= 1.5;
+            if (distance < required) canMove = false;
+        }
+
+        // Entering the box, yield to cross traffic already inside it
+        Vehicle self;
+        self.x = lane->x[i];
+        self.y = lane->y[i];
+        if (canMove && !isInsideIntersection(&self)) {
+            float nextX = self.x, nextY = self.y;
+            if (!turning) {
+                if (pos == lane->x) nextX += sign * lane->speed[i];
+                else nextY += sign * lane->speed[i];
+            }
+            if (isNearIntersection(nextX, nextY) && boxConflict(store, laneIndex, nextX, nextY)) {
+                canMove = false;
+                junction->conflictsAvoided++;
+            }
+        }
+
+        float stop;
+        if (!canMove && zebraStop(lane->direction, self.x, self.y, &stop)) {
+            lane->waitTime[i]++;
+            pos[i] = stop;
+            continue;
+        }
+        if (!canMove) {
+            lane->waitTime[i]++;
+        } else if (turning) {
+            lane->progress[i] += lane->speed[i] / 100.0f;
+            if (lane->progress[i] >= 1.0f) {
+                lane->progress[i] = 1.0f;
+                lane->flags[i] = (uint8_t)((lane->flags[i] & ~LANE_FLAG_TURNING) | LANE_FLAG_PASSED);
+            }
+        } else {
+            pos[i] += sign * lane->speed[i];
+        }
+
+        // Only the front vehicle can leave; the next one is then at the front
+        if (i == head && pos[i] * sign > exitLine * sign) {
+            Vehicle vehicle;
+            laneVehicle(lane, i, &vehicle);
+            finishTrip(junction, &vehicle);
+            head++;
+            exited++;
+        }
+    }
+    lane->front = head;
+    lane->count = end - head;
+    if (lane->count == 0) lane->front = 0;
+    return exited;
+}
+
+// Returns how many vehicles left the window this tick
+int updateVehicleStore(VehicleStore* store, Junction* junction) {
+    collectNearBox(store);
+    int exited = 0;
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        exited += updateLane(store, i, junction);
+        junction->queues[i]->external = store->lanes[i].count;
+    }
+    store->exited += exited;
+    return exited;
+}
+
+// recordStranded for vehicles held in the store
+int recordStoreStranded(const VehicleStore* store, DelayHistogram* stranded) {
+    int count = 0;
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        const LaneStore* lane = &store->lanes[i];
+        for (int j = lane->front; j < lane->front + lane->count; j++) {
+            if (lane->flags[j] & LANE_FLAG_PASSED) continue;
+            recordDelay(stranded, (double)lane->waitTime[j] * SIM_TICK_MS);
+            count++;
+        }
+    }
+    return count;
+}
+
+// Same tick as stepJunction, but vehicles live in the store instead of the queues
+void stepVehicleStore(VehicleStore* store, Junction* junction, Transport* transport) {
+    TRACE_SCOPE("step");
+    int laneSizes[NUM_QUEUES];
+    int queueLengths[4] = {0};
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        laneSizes[i] = store->lanes[i].count;
+        queueLengths[i / 3] += laneSizes[i];
+    }
+
+    if (transport) {
+        TRACE_SCOPE("poll_transport");
+        junction->vehiclesIngested += pollTransport(transport, junction->queues, junction->pool,
+                                                    (double)junction->tick * SIM_TICK_MS);
+    }
+
+    junction->vehicleGenTimer++;
+    if (junction->config.spawner && junction->vehicleGenTimer >= junction->config.spawnIntervalTicks) {
+        TRACE_SCOPE("spawn");
+        junction->vehicleGenTimer = 0;
+        spawnVehicles(junction, queueLengths);
+    }
+    moveQueuesToStore(store, junction->queues, junction->pool);
+
+    {
+        TRACE_SCOPE("update_positions");
+        junction->vehiclesExited += updateVehicleStore(store, junction);
+    }
+    updateLights(junction, SIM_TICK_MS, laneSizes);
+    junction->tick++;
+}
@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <string.h>
+#include "network.h"
+#include "traffic_generator.h"
+#include "trace.h"
+
+#define OUTBOX_INITIAL 16
+#define NETWORK_SEED_STRIDE 0x9E3779B97F4A7C15ULL
+
+// Shared by the workers of one runNetwork call. Threads are created first and
+// then released, so the barrier can be sized by how many actually started.
+typedef struct {
+    Network* network;
+    long ticks;
+    pthread_barrier_t barrier;
+    pthread_mutex_t lock;
+    pthread_cond_t go;
+    bool released;
+} NetworkRun;
+
+typedef struct {
+    NetworkRun* run;
+    int first, last;            // Node index range [first, last)
+} NetworkWorker;
+
+static bool pushOutbox(Outbox* box, const Vehicle* vehicle) {
+    if (box->count == box->capacity) {
+        int capacity = box->capacity ? box->capacity * 2 : OUTBOX_INITIAL;
+        Vehicle* items = (Vehicle*)realloc(box->items, capacity * sizeof(Vehicle));
+        if (!items) return false;
+        box->items = items;
+        box->capacity = capacity;
+    }
+    box->items[box->count++] = *vehicle;
+    return true;
+}
+
+// Side of the junction a lane drives off: A moves up, B left, C right, D down
+static NetworkSide exitSide(Direction direction) {
+    switch (direction) {
+        case DIRECTION_SOUTH: return SIDE_NORTH;
+        case DIRECTION_WEST:  return SIDE_WEST;
+        case DIRECTION_EAST:  return SIDE_EAST;
+        default:              return SIDE_SOUTH;
+    }
+}
+
+static bool handOff(void* context, const Vehicle* vehicle) {
+    NetworkNode* node = (NetworkNode*)context;
+    NetworkSide side = exitSide(vehicle->startDirection);
+    if (node->neighbour[side] < 0) {
+        node->leftNetwork++;
+        return false; // Trip ends here
+    }
+    if (!pushOutbox(&node->outbox[node->writeSlot][side], vehicle)) {
+        node->refused++;
+        return false;
+    }
+    node->handedOff++;
+    return true;
+}
+
+// Re-enters a handed-off vehicle at the edge of the downstream junction; it
+// keeps its id, type, lane and accumulated waiting time but picks a new turn
+static bool admitArrival(NetworkNode* node, const Vehicle* arriving) {
+    Junction* junction = node->junction;
+    Vehicle vehicle = *arriving;
+    vehicle.turning = false;
+    vehicle.turnAngle = 0.0f;
+    vehicle.progress = 0.0f;
+    vehicle.passedIntersection = false;
+    setVehiclePath(&vehicle, &junction->roadRng[vehicle.startDirection]);
+    placeVehicleAtEntry(&vehicle);
+    vehicle.prevX = vehicle.x;
+    vehicle.prevY = vehicle.y;
+    return admitVehicle(junction->queues, junction->pool, &vehicle) == ENQUEUE_OK;
+}
+
+static void keepPending(NetworkNode* node, Outbox* retry, const Vehicle* vehicle) {
+    if (retry->count >= NETWORK_PENDING_LIMIT || !pushOutbox(retry, vehicle)) node->refused++;
+}
+
+// Pulls what the neighbours sent last tick, then advances this junction one tick
+void stepNetworkNode(Network* network, int index, long tick) {
+    NetworkNode* node = &network->nodes[index];
+    int readSlot = (tick - 1) & 1;
+
+    // Earlier refusals go first so arrival order on each road is kept
+    Outbox retry = {0};
+    for (int i = 0; i < node->pending.count; i++) {
+        if (admitArrival(node, &node->pending.items[i])) node->arrived++;
+        else keepPending(node, &retry, &node->pending.items[i]);
+    }
+    if (tick > 0) {
+        for (int side = 0; side < 4; side++) {
+            int from = node->neighbour[side];
+            if (from < 0) continue;
+            // The neighbour to our north sends through its south side, and so on
+            const Outbox* box = &network->nodes[from].outbox[readSlot][3 - side];
+            for (int i = 0; i < box->count; i++) {
+                if (admitArrival(node, &box->items[i])) node->arrived++;
+                else keepPending(node, &retry, &box->items[i]);
+            }
+        }
+    }
+    free(node->pending.items);
+    node->pending = retry;
+
+    node->writeSlot = tick & 1;
+    for (int side = 0; side < 4; side++) node->outbox[node->writeSlot][side].count = 0;
+    stepJunction(node->junction, NULL);
+}
+
+Network* createNetwork(int cols, int rows, const JunctionConfig* config) {
+    if (cols <= 0 || rows <= 0) return NULL;
+    Network* network = (Network*)calloc(1, sizeof(Network));
+    if (!network) return NULL;
+    network->cols = cols;
+    network->rows = rows;
+    network->nodes = (NetworkNode*)calloc((size_t)cols * rows, sizeof(NetworkNode));
+    if (!network->nodes) {
+        free(network);
+        return NULL;
+    }
+
+    JunctionConfig defaults;
+    if (!config) {
+        defaultJunctionConfig(&defaults);
+        config = &defaults;
+    }
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int index = r * cols + c;
+            NetworkNode* node = &network->nodes[index];
+            // Each junction gets its own seed so their spawners are independent
+            JunctionConfig local = *config;
+            local.seed = config->seed + (uint64_t)index * NETWORK_SEED_STRIDE;
+            node->junction = createJunction(&local);
+            if (!node->junction) {
+                destroyNetwork(network);
+                return NULL;
+            }
+            node->junction->onExit = handOff;
+            node->junction->exitContext = node;
+            node->neighbour[SIDE_NORTH] = r > 0 ? index - cols : -1;
+            node->neighbour[SIDE_WEST] = c > 0 ? index - 1 : -1;
+            node->neighbour[SIDE_EAST] = c < cols - 1 ? index + 1 : -1;
+            node->neighbour[SIDE_SOUTH] = r < rows - 1 ? index + cols : -1;
+        }
+    }
+    return network;
+}
+
+void destroyNetwork(Network* network) {
+    if (!network) return;
+    for (int i = 0; i < network->cols * network->rows; i++) {
+        NetworkNode* node = &network->nodes[i];
+        destroyJunction(node->junction);
+        for (int slot = 0; slot < 2; slot++)
+            for (int side = 0; side < 4; side++) free(node->outbox[slot][side].items);
+        free(node->pending.items);
+    }
+    free(network->nodes);
+    free(network);
+}
+
+static void* networkWorkerMain(void* arg) {
+    NetworkWorker* worker = (NetworkWorker*)arg;
+    NetworkRun* run = worker->run;
+    pthread_mutex_lock(&run->lock);
+    while (!run->released) pthread_cond_wait(&run->go, &run->lock);
+    pthread_mutex_unlock(&run->lock);
+
+    long base = run->network->tick;
+    for (long t = 0; t < run->ticks; t++) {
+        TRACE_SCOPE("network_tick");
+        for (int i = worker->first; i < worker->last; i++) stepNetworkNode(run->network, i, base + t);
+        pthread_barrier_wait(&run->barrier);
+    }
+    return NULL;
+}
+
+// Splits the grid into contiguous blocks of junctions, one per thread. The
+// calling thread is one of the workers; if fewer threads can be created than
+// asked for, the blocks are spread over those that were.
+bool runNetwork(Network* network, long ticks, int threadCount) {
+    int count = network->cols * network->rows;
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > count) threadCount = count;
+
+    NetworkWorker* workers = (NetworkWorker*)calloc(threadCount, sizeof(NetworkWorker));
+    pthread_t* threads = (pthread_t*)calloc(threadCount, sizeof(pthread_t));
+    if (!workers || !threads) {
+        free(workers);
+        free(threads);
+        return false;
+    }
+    NetworkRun run = {0};
+    run.network = network;
+    run.ticks = ticks;
+    pthread_mutex_init(&run.lock, NULL);
+    pthread_cond_init(&run.go, NULL);
+
+    int started = 1;
+    for (int w = 1; w < threadCount; w++) {
+        workers[w].run = &run;
+        if (pthread_create(&threads[w], NULL, networkWorkerMain, &workers[w]) != 0) break;
+        started++;
+    }
+    for (int w = 0; w < started; w++) {
+        workers[w].run = &run;
+        workers[w].first = (int)((long)count * w / started);
+        workers[w].last = (int)((long)count * (w + 1) / started);
+    }
+    pthread_barrier_init(&run.barrier, NULL, started);
+
+    pthread_mutex_lock(&run.lock);
+    run.released = true;
+    pthread_cond_broadcast(&run.go);
+    pthread_mutex_unlock(&run.lock);
+
+    networkWorkerMain(&workers[0]);
+    for (int w = 1; w < started; w++) pthread_join(threads[w], NULL);
+    network->tick += ticks;
+
+    pthread_barrier_destroy(&run.barrier);
+    pthread_cond_destroy(&run.go);
+    pthread_mutex_destroy(&run.lock);
+    free(workers);
+    free(threads);
+    return true;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include "network.h"
+#include "trace.h"
+
+#define DEFAULT_NETWORK_TICKS 100000
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -g, --grid CxR      Junctions per row and column (default 4x4)\n"
+        "  -j, --threads N     Worker threads (default: online CPUs)\n"
+        "  -t, --ticks N       Number of simulation ticks to run (default %d)\n"
+        "  -s, --seconds S     Simulated seconds to run (overrides --ticks)\n"
+        "      --seed N        Base seed; junction i uses a seed derived from it\n"
+        "      --light-cycle-ms N   Green time per phase (default %d)\n"
+        "      --spawn-interval N   Ticks between built-in spawn rounds (default %d)\n"
+        "      --controller C  Signal controller: fixed (default), actuated, max-pressure or priority\n"
+        "      --preempt       Emergency vehicles preempt the lights at every junction\n"
+        "  -h, --help          Show this help\n",
+        program, DEFAULT_NETWORK_TICKS, LIGHT_CYCLE_TIME, VEHICLE_GEN_INTERVAL);
+}
+
+int main(int argc, char* argv[]) {
+    int cols = 4, rows = 4;
+    long ticks = DEFAULT_NETWORK_TICKS;
+    long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+    JunctionConfig config;
+    defaultJunctionConfig(&config);
+
+    static struct option options[] = {
+        {"grid", required_argument, 0, 'g'},
+        {"threads", required_argument, 0, 'j'},
+        {"ticks", required_argument, 0, 't'},
+        {"seconds", required_argument, 0, 's'},
+        {"seed", required_argument, 0, 'R'},
+        {"light-cycle-ms", required_argument, 0, 'L'},
+        {"spawn-interval", required_argument, 0, 'I'},
+        {"controller", required_argument, 0, 'C'},
+        {"preempt", no_argument, 0, 'X'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "g:j:t:s:h", options, NULL)) != -1) {
+        switch (opt) {
+            case 'g':
+                if (sscanf(optarg, "%dx%d", &cols, &rows) != 2) { printUsage(argv[0]); return 1; }
+                break;
+            case 'j': threadCount = atol(optarg); break;
+            case 't': ticks = atol(optarg); break;
+            case 's': ticks = (long)(atof(optarg) * 1000.0 / SIM_TICK_MS); break;
+            case 'R': config.seed = parseSeed(optarg); break;
+            case 'L': config.lightCycleMs = atoi(optarg); break;
+            case 'I': config.spawnIntervalTicks = atoi(optarg); break;
+            case 'X': config.preemption = true; break;
+            case 'C':
+                config.controller = parseControllerKind(optarg);
+                if (config.controller == CONTROLLER_COUNT) { printUsage(argv[0]); return 1; }
+                break;
+            case 'h': printUsage(argv[0]); return 0;
+            default: printUsage(argv[0]); return 1;
+        }
+    }
+    if (ticks <= 0 || cols <= 0 || rows <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Network* network = createNetwork(cols, rows, &config);
+    if (!network) {
+        fprintf(stderr, "Network creation failed\n");
+        return 1;
+    }
+
+    TRACE_INIT(TRACE_DEFAULT_PATH);
+    double start = nowSeconds();
+    bool ok = runNetwork(network, ticks, (int)threadCount);
+    double elapsed = nowSeconds() - start;
+    if (!ok) {
+        fprintf(stderr, "Could not start network workers\n");
+        destroyNetwork(network);
+        return 1;
+    }
+
+    long spawned = 0, handedOff = 0, leftNetwork = 0, arrived = 0, refused = 0, drops = 0;
+    DelayHistogram waits;
+    memset(&waits, 0, sizeof(waits));
+    int count = cols * rows;
+    for (int i = 0; i < count; i++) {
+        NetworkNode* node = &network->nodes[i];
+        spawned += node->junction->vehiclesSpawned;
+        drops += countQueueDrops(node->junction);
+        handedOff += node->handedOff;
+        leftNetwork += node->leftNetwork;
+        arrived += node->arrived;
+        refused += node->refused;
+        mergeDelayHistogram(&waits, &node->junction->waitStats);
+    }
+
+    double simSeconds = ticks * (SIM_TICK_MS / 1000.0);
+    printf("seed:               %llu\n", (unsigned long long)config.seed);
+    printf("junctions:          %d (%dx%d)\n", count, cols, rows);
+    printf("threads:            %ld\n", threadCount < count ? threadCount : (long)count);
+    printf("ticks:              %ld\n", ticks);
+    printf("wall seconds:       %.3f\n", elapsed);
+    printf("ticks/sec:          %.0f\n", elapsed > 0 ? ticks / elapsed : 0.0);
+    printf("junction-ticks/sec: %.0f\n", elapsed > 0 ? (double)ticks * count / elapsed : 0.0);
+    printf("speedup:            %.1fx\n", elapsed > 0 ? simSeconds / elapsed : 0.0);
+    printf("vehicles spawned:   %ld\n", spawned);
+    printf("handed off:         %ld (arrived %ld)\n", handedOff, arrived);
+    printf("left network:       %ld\n", leftNetwork);
+    printf("hand-offs refused:  %ld\n", refused);
+    printf("queue drops:        %ld\n", drops);
+    printf("trip wait mean/p95: %.1f / %.1f s\n", meanDelay(&waits) / 1000.0, delayPercentile(&waits, 95) / 1000.0);
+
+    TRACE_SHUTDOWN();
+    destroyNetwork(network);
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "overlay.h"
+
+#define OVERLAY_MARGIN 8
+#define OVERLAY_PADDING 6
+
+static const SDL_Color OVERLAY_TEXT_COLOR = {235, 235, 235, 255};
+
+// Returns false (and leaves the overlay permanently hidden) if the font can't be loaded
+bool initOverlay(Overlay* overlay, const char* fontPath, int pointSize) {
+    memset(overlay, 0, sizeof(*overlay));
+    if (TTF_Init() != 0) {
+        fprintf(stderr, "SDL_ttf initialization failed: %s\n", TTF_GetError());
+        return false;
+    }
+    overlay->font = TTF_OpenFont(fontPath ? fontPath : OVERLAY_DEFAULT_FONT, pointSize);
+    if (!overlay->font) {
+        fprintf(stderr, "Overlay disabled, could not open font: %s\n", TTF_GetError());
+        TTF_Quit();
+        return false;
+    }
+    return true;
+}
+
+static void releaseLine(OverlayLine* line) {
+    if (line->texture) SDL_DestroyTexture(line->texture);
+    line->texture = NULL;
+    line->dirty = true;
+}
+
+void destroyOverlay(Overlay* overlay) {
+    for (int i = 0; i < OVERLAY_MAX_LINES; i++) releaseLine(&overlay->lines[i]);
+    for (int i = 0; i < NUM_LIGHTS; i++) releaseLine(&overlay->lightLabels[i]);
+    if (overlay->font) {
+        TTF_CloseFont(overlay->font);
+        TTF_Quit();
+    }
+    overlay->font = NULL;
+    overlay->visible = false;
+}
+
+// Call when the renderer has lost its textures
+void invalidateOverlay(Overlay* overlay) {
+    for (int i = 0; i < OVERLAY_MAX_LINES; i++) overlay->lines[i].dirty = true;
+    for (int i = 0; i < NUM_LIGHTS; i++) overlay->lightLabels[i].dirty = true;
+}
+
+static void setLineText(OverlayLine* line, const char* text) {
+    if (strcmp(line->text, text) == 0) return;
+    snprintf(line->text, sizeof(line->text), "%s", text);
+    line->dirty = true;
+}
+
+static void setLine(Overlay* overlay, const char* format, ...) {
+    if (overlay->lineCount >= OVERLAY_MAX_LINES) return;
+    char text[OVERLAY_TEXT_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    setLineText(&overlay->lines[overlay->lineCount++], text);
+}
+
+// workMs is the time spent drawing and presenting, excluding the frame cap delay
+void recordOverlayFrame(Overlay* overlay, double workMs) {
+    overlay->windowWorkMs += workMs;
+    overlay->windowFrames++;
+}
+
+// Sim rates come from the tick counter in the snapshots, since the sim runs on
+// its own thread and no longer advances once per frame
+void updateOverlay(Overlay* overlay, const Snapshot* snapshot, double timeScale, double nowMs) {
+    if (!overlay->font) return;
+    if (overlay->windowStartMs == 0) {
+        overlay->windowStartMs = nowMs;
+        overlay->windowStartTick = snapshot->tick;
+    }
+    double windowMs = nowMs - overlay->windowStartMs;
+    if (windowMs < OVERLAY_REFRESH_MS || overlay->windowFrames == 0) return;
+
+    overlay->lineCount = 0;
+    setLine(overlay, "frame %5.2f ms  %4.0f fps",
+        overlay->windowWorkMs / overlay->windowFrames, overlay->windowFrames * 1000.0 / windowMs);
+    setLine(overlay, "sim %7.0f ticks/s  x%.1f", (snapshot->tick - overlay->windowStartTick) * 1000.0 / windowMs,
+        timeScale);
+
+    const char roads[4] = {'A', 'B', 'C', 'D'};
+    for (int dir = 0; dir < 4; dir++) {
+        const int* size = &snapshot->queueSizes[dir * 3];
+        const float* wait = &snapshot->waitingTimes[dir * 3];
+        setLine(overlay, "%c  queue %3d %3d %3d  wait %5.1f %5.1f %5.1f", roads[dir],
+            size[0], size[1], size[2], wait[0], wait[1], wait[2]);
+    }
+
+    setLine(overlay, "pool %d/%d  peak %d  exhausted %ld", snapshot->poolInUse,
+        snapshot->poolCapacity, snapshot->poolHighWater, snapshot->poolExhausted);
+    setLine(overlay, "drops %ld  backpressure %ld", snapshot->drops, snapshot->backpressured);
+    setLine(overlay, "exited %ld  in box yields %ld", snapshot->vehiclesExited, snapshot->conflictsAvoided);
+    if (snapshot->droppedSteps > 0) setLine(overlay, "sim behind: %ld steps dropped", snapshot->droppedSteps);
+
+    overlay->windowStartMs = nowMs;
+    overlay->windowStartTick = snapshot->tick;
+    overlay->windowWorkMs = 0;
+    overlay->windowFrames = 0;
+}
+
+static void rasterizeLine(SDL_Renderer* renderer, Overlay* overlay, OverlayLine* line) {
+    if (!line->dirty) return;
+    if (line->texture) SDL_DestroyTexture(line->texture);
+    line->texture = NULL;
+    line->dirty = false;
+    if (line->text[0] == '\0') return;
+
+    SDL_Surface* surface = TTF_RenderText_Blended(overlay->font, line->text, OVERLAY_TEXT_COLOR);
+    if (!surface) return;
+    line->texture = SDL_CreateTextureFromSurface(renderer, surface);
+    line->width = surface->w;
+    line->height = surface->h;
+    SDL_FreeSurface(surface);
+    overlay->rasterized++;
+}
+
+static void drawLine(SDL_Renderer* renderer, Overlay* overlay, OverlayLine* line) {
+    rasterizeLine(renderer, overlay, line);
+    if (!line->texture) return;
+    SDL_Rect dest = {line->x, line->y, line->width, line->height};
+    SDL_RenderCopy(renderer, line->texture, NULL, &dest);
+}
+
+void drawOverlay(SDL_Renderer* renderer, Overlay* overlay, TrafficLight lights[NUM_LIGHTS]) {
+    if (!overlay->visible || !overlay->font) return;
+
+    int lineHeight = TTF_FontLineSkip(overlay->font);
+    int panelWidth = 0;
+    for (int i = 0; i < overlay->lineCount; i++) {
+        OverlayLine* line = &overlay->lines[i];
+        rasterizeLine(renderer, overlay, line);
+        line->x = OVERLAY_MARGIN + OVERLAY_PADDING;
+        line->y = OVERLAY_MARGIN + OVERLAY_PADDING + i * lineHeight;
+        if (line->width > panelWidth) panelWidth = line->width;
+    }
+
+    if (overlay->lineCount > 0) {
+        SDL_Rect panel = {OVERLAY_MARGIN, OVERLAY_MARGIN, panelWidth + 2 * OVERLAY_PADDING,
+                          overlay->lineCount * lineHeight + 2 * OVERLAY_PADDING};
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 170);
+        SDL_RenderFillRect(renderer, &panel);
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        for (int i = 0; i < overlay->lineCount; i++) drawLine(renderer, overlay, &overlay->lines[i]);
+    }
+
+    for (int i = 0; i < NUM_LIGHTS; i++) {
+        OverlayLine* label = &overlay->lightLabels[i];
+        setLineText(label, lights[i].label);
+        label->x = lights[i].x;
+        label->y = lights[i].y + 32; // Just below the light box
+        drawLine(renderer, overlay, label);
+    }
+}
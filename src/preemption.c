@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include <string.h>
+#include "preemption.h"
+
+static bool entryBefore(const EmergencyEntry* a, const EmergencyEntry* b) {
+    if (a->detectedTick != b->detectedTick) return a->detectedTick < b->detectedTick;
+    return a->seq < b->seq;
+}
+
+static void placeEntry(Preemption* preemption, int slot, const EmergencyEntry* entry) {
+    preemption->heap[slot] = *entry;
+    preemption->position[entry->poolIndex] = slot;
+}
+
+static void siftUp(Preemption* preemption, int slot) {
+    EmergencyEntry entry = preemption->heap[slot];
+    while (slot > 0) {
+        int parent = (slot - 1) / 2;
+        if (!entryBefore(&entry, &preemption->heap[parent])) break;
+        placeEntry(preemption, slot, &preemption->heap[parent]);
+        slot = parent;
+    }
+    placeEntry(preemption, slot, &entry);
+}
+
+static void siftDown(Preemption* preemption, int slot) {
+    EmergencyEntry entry = preemption->heap[slot];
+    for (;;) {
+        int child = slot * 2 + 1;
+        if (child >= preemption->count) break;
+        if (child + 1 < preemption->count && entryBefore(&preemption->heap[child + 1], &preemption->heap[child])) {
+            child++;
+        }
+        if (!entryBefore(&preemption->heap[child], &entry)) break;
+        placeEntry(preemption, slot, &preemption->heap[child]);
+        slot = child;
+    }
+    placeEntry(preemption, slot, &entry);
+}
+
+Preemption* createPreemption(int poolCapacity, int queueCount) {
+    Preemption* preemption = (Preemption*)calloc(1, sizeof(Preemption));
+    if (!preemption) return NULL;
+    preemption->heap = (EmergencyEntry*)malloc(sizeof(EmergencyEntry) * poolCapacity);
+    preemption->position = (int*)malloc(sizeof(int) * poolCapacity);
+    preemption->seenEnqueued = (long*)calloc(queueCount, sizeof(long));
+    if (!preemption->heap || !preemption->position || !preemption->seenEnqueued) {
+        destroyPreemption(preemption);
+        return NULL;
+    }
+    memset(preemption->position, -1, sizeof(int) * poolCapacity);
+    preemption->poolCapacity = poolCapacity;
+    preemption->queueCount = queueCount;
+    return preemption;
+}
+
+void destroyPreemption(Preemption* preemption) {
+    if (!preemption) return;
+    free(preemption->heap);
+    free(preemption->position);
+    free(preemption->seenEnqueued);
+    free(preemption);
+}
+
+// Starts tracking emergency vehicles enqueued since the previous pass. New
+// vehicles are always at the rear, so only those slots are looked at.
+// Returns how many were found.
+int detectEmergencies(Preemption* preemption, Queue* queues[], const VehiclePool* pool, long tick) {
+    int found = 0;
+    for (int i = 0; i < preemption->queueCount; i++) {
+        Queue* queue = queues[i];
+        long fresh = queue->enqueued - preemption->seenEnqueued[i];
+        preemption->seenEnqueued[i] = queue->enqueued;
+        if (fresh > queue->size) fresh = queue->size;
+        for (int j = queue->size - (int)fresh; j < queue->size; j++) {
+            Vehicle* vehicle = queueAt(queue, j);
+            if (!isEmergencyVehicle(vehicle)) continue;
+            int index = vehiclePoolIndex(pool, vehicle);
+            if (index < 0 || index >= preemption->poolCapacity || preemption->position[index] >= 0) continue;
+            EmergencyEntry entry = {tick, preemption->detected++, index, i};
+            preemption->count++;
+            placeEntry(preemption, preemption->count - 1, &entry);
+            siftUp(preemption, preemption->count - 1);
+            found++;
+        }
+    }
+    return found;
+}
+
+// The vehicle in poolIndex has left the junction. Records its latency if it
+// was being tracked; returns whether it was.
+bool clearEmergency(Preemption* preemption, int poolIndex, long tick, int tickMs) {
+    if (poolIndex < 0 || poolIndex >= preemption->poolCapacity) return false;
+    int slot = preemption->position[poolIndex];
+    if (slot < 0) return false;
+
+    recordDelay(&preemption->latency, (double)(tick - preemption->heap[slot].detectedTick) * tickMs);
+    preemption->cleared++;
+    preemption->position[poolIndex] = -1;
+    preemption->count--;
+    if (slot == preemption->count) return true;
+    placeEntry(preemption, slot, &preemption->heap[preemption->count]);
+    if (slot > 0 && entryBefore(&preemption->heap[slot], &preemption->heap[(slot - 1) / 2])) siftUp(preemption, slot);
+    else siftDown(preemption, slot);
+    return true;
+}
+
+// Lane of the longest-waiting emergency vehicle, or -1 if there is none
+int preemptedQueue(const Preemption* preemption) {
+    return preemption->count > 0 ? preemption->heap[0].queueIndex : -1;
+}
@@ -1,44 +1,97 @@
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "queue.h"
 
+static int roundUpPowerOfTwo(int n) {
+    int capacity = 1;
+    while (capacity < n && capacity < MAX_QUEUE_CAPACITY) capacity <<= 1;
+    return capacity;
+}
+
 Queue* createQueue(Direction direction, LanePosition lane) {
-    Queue* queue = (Queue*)malloc(sizeof(Queue));
+    return createQueueWithCapacity(direction, lane, DEFAULT_QUEUE_CAPACITY, QUEUE_OVERFLOW_REJECT);
+}
+
+Queue* createQueueWithCapacity(Direction direction, LanePosition lane, int capacity, OverflowPolicy policy) {
+    Queue* queue = (Queue*)calloc(1, sizeof(Queue));
     if (!queue) return NULL;
 
+    queue->capacity = roundUpPowerOfTwo(capacity > 0 ? capacity : DEFAULT_QUEUE_CAPACITY);
+    queue->mask = queue->capacity - 1;
+    queue->items = (Vehicle**)calloc(queue->capacity, sizeof(Vehicle*));
+    if (!queue->items) {
+        free(queue);
+        return NULL;
+    }
+
     queue->front = 0;
     queue->rear = -1;
     queue->size = 0;
     queue->direction = direction;
     queue->lane = lane;
     queue->waitingTime = 0;
+    queue->overflowPolicy = policy;
 
     queue->isPriorityLane = (lane == LANE_CENTER) &&
                            (direction == DIRECTION_SOUTH || // AL2
                             direction == DIRECTION_WEST ||  // BL2
                             direction == DIRECTION_EAST ||  // CL2
                             direction == DIRECTION_NORTH);  // DL2
-
-    for (int i = 0; i < MAX_QUEUE_SIZE; i++) {
-        queue->items[i] = NULL;
-    }
     return queue;
 }
 
+void destroyQueue(Queue* queue) {
+    if (!queue) return;
+    free(queue->items);
+    free(queue);
+}
+
 bool isEmpty(Queue* queue) {
     return (queue->size == 0);
 }
 
 bool isFull(Queue* queue) {
-    return (queue->size == MAX_QUEUE_SIZE);
+    return (queue->size + queue->external >= queue->capacity);
 }
 
-void enqueue(Queue* queue, Vehicle* vehicle) {
-    if (!queue || !vehicle || isFull(queue)) return;
+// Doubles the ring, unwrapping the live items to start at index 0
+static bool growQueue(Queue* queue) {
+    if (queue->capacity >= MAX_QUEUE_CAPACITY) return false;
+    int capacity = queue->capacity * 2;
+    Vehicle** items = (Vehicle**)calloc(capacity, sizeof(Vehicle*));
+    if (!items) return false;
+    for (int i = 0; i < queue->size; i++) {
+        items[i] = queue->items[(queue->front + i) & queue->mask];
+    }
+    free(queue->items);
+    queue->items = items;
+    queue->capacity = capacity;
+    queue->mask = capacity - 1;
+    queue->front = 0;
+    queue->rear = queue->size - 1;
+    queue->grows++;
+    return true;
+}
 
-    queue->rear = (queue->rear + 1) % MAX_QUEUE_SIZE;
+EnqueueResult enqueue(Queue* queue, Vehicle* vehicle) {
+    if (!queue || !vehicle) return ENQUEUE_REJECTED;
+
+    if (isFull(queue)) {
+        if (queue->overflowPolicy == QUEUE_OVERFLOW_BACKPRESSURE) {
+            queue->backpressured++;
+            return ENQUEUE_BACKPRESSURE;
+        }
+        if (queue->overflowPolicy != QUEUE_OVERFLOW_GROW || !growQueue(queue)) {
+            queue->drops++;
+            return ENQUEUE_REJECTED;
+        }
+    }
+
+    queue->rear = (queue->rear + 1) & queue->mask;
     queue->items[queue->rear] = vehicle;
     queue->size++;
+    queue->enqueued++;
 
     vehicle->isPriorityLane = queue->isPriorityLane;
 
@@ -49,6 +102,7 @@ void enqueue(Queue* queue, Vehicle* vehicle) {
     } else {
         queue->waitingTime += 1;
     }
+    return ENQUEUE_OK;
 }
 
 Vehicle* dequeue(Queue* queue) {
@@ -56,7 +110,7 @@ Vehicle* dequeue(Queue* queue) {
 
     Vehicle* vehicle = queue->items[queue->front];
     queue->items[queue->front] = NULL;
-    queue->front = (queue->front + 1) % MAX_QUEUE_SIZE;
+    queue->front = (queue->front + 1) & queue->mask;
     queue->size--;
 
     if (vehicle) {
@@ -81,6 +135,17 @@ Vehicle* peekFront(Queue* queue) {
     return queue->items[queue->front];
 }
 
+// index counts from the front (0) towards the rear
+Vehicle* queueAt(Queue* queue, int index) {
+    return queue->items[(queue->front + index) & queue->mask];
+}
+
+OverflowPolicy parseOverflowPolicy(const char* name) {
+    if (name && strcmp(name, "grow") == 0) return QUEUE_OVERFLOW_GROW;
+    if (name && strcmp(name, "backpressure") == 0) return QUEUE_OVERFLOW_BACKPRESSURE;
+    return QUEUE_OVERFLOW_REJECT;
+}
+
 bool isEmergencyVehicle(Vehicle* vehicle) {
     return vehicle && vehicle->type > 0;
 }
@@ -90,12 +155,12 @@ bool isPriorityLaneActive(Queue* queue) {
 }
 
 // Next, let's fix the vehicle path setting logic
-void setVehiclePath(Vehicle* vehicle) {
+void setVehiclePath(Vehicle* vehicle, Rng* rng) {
     float turnProbability = 0.6; // 60% chance to turn from left lane
 
     if (vehicle->startLane == LANE_LEFT) {
         // Left lane: 60% chance to turn left, 40% chance to go straight
-        if ((float)rand() / RAND_MAX < turnProbability) {
+        if (rngFloat(rng) < turnProbability) {
             vehicle->turning = true;
             // Set end direction based on left turn
             switch (vehicle->startDirection) {
@@ -122,7 +187,7 @@ void setVehiclePath(Vehicle* vehicle) {
         vehicle->turning = true;
 
         // 50% chance to turn left, 50% chance to turn right
-        if ((float)rand() / RAND_MAX < 0.5) {
+        if (rngFloat(rng) < 0.5f) {
             // Turn left
             switch (vehicle->startDirection) {
                 case DIRECTION_SOUTH:
@@ -211,6 +276,17 @@ int getQueueSize(Direction direction, LanePosition lane) {
     return 0;
 }
 
+// Which of the four lights controls traffic entering from a road
+int lightForDirection(Direction direction) {
+    switch (direction) {
+        case DIRECTION_SOUTH: return 1; // A - controlled by t2 (index 1)
+        case DIRECTION_WEST:  return 0; // B - controlled by t1 (index 0)
+        case DIRECTION_EAST:  return 2; // C - controlled by t3 (index 2)
+        case DIRECTION_NORTH: return 3; // D - controlled by t4 (index 3)
+    }
+    return -1;
+}
+
 // First, let's define the traffic light control logic
 bool canProceedThroughIntersection(Vehicle* vehicle,  bool trafficLights[4]) {
     // Emergency vehicles can always proceed
@@ -220,22 +296,7 @@ bool canProceedThroughIntersection(Vehicle* vehicle,  bool trafficLights[4]) {
     if (vehicle->passedIntersection) return true;
 
     // Check traffic light states based on direction
-    int trafficLight = -1;
-
-    switch (vehicle->startDirection) {
-        case DIRECTION_SOUTH: // A - controlled by t2 (index 1)
-            trafficLight = 1;
-            break;
-        case DIRECTION_WEST:  // B - controlled by t3 (index 2)
-            trafficLight = 0;
-            break;
-        case DIRECTION_EAST:  // C - controlled by t1 (index 0)
-            trafficLight = 2;
-            break;
-        case DIRECTION_NORTH: // D - controlled by t4 (index 3)
-            trafficLight = 3;
-            break;
-    }
+    int trafficLight = lightForDirection(vehicle->startDirection);
 
     // If light is red, stop
     if (trafficLight  >= 0 && !trafficLights[trafficLight]) {
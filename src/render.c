@@ -0,0 +1,234 @@
+#include <stdlib.h>
+#include "render.h"
+#include "traffic_generator.h"
+
+static const SDL_Color VEHICLE_COLORS[VEHICLE_TYPES] = {
+    {30, 144, 255, 255},  // Regular
+    {255, 0, 0, 255},     // Ambulance
+    {0, 0, 139, 255},     // Police
+    {255, 140, 0, 255}    // Fire truck
+};
+
+void initSceneCache(SceneCache* cache) {
+    cache->roads = NULL;
+    cache->valid = false;
+    cache->rectCapacity = 0;
+    for (int t = 0; t < VEHICLE_TYPES; t++) {
+        cache->vehicleRects[t] = NULL;
+        cache->rectCounts[t] = 0;
+    }
+}
+
+// Call when the window is resized or the renderer loses its targets
+void invalidateSceneCache(SceneCache* cache) {
+    cache->valid = false;
+}
+
+void destroySceneCache(SceneCache* cache) {
+    if (cache->roads) SDL_DestroyTexture(cache->roads);
+    for (int t = 0; t < VEHICLE_TYPES; t++) free(cache->vehicleRects[t]);
+    initSceneCache(cache);
+}
+
+void drawRoads(SDL_Renderer* renderer) {
+    // Road background - Darker gray for better contrast
+    SDL_SetRenderDrawColor(renderer, 40, 40, 40, 255);
+
+    // Main roads
+    SDL_Rect horizontalRoad = {
+        0, WINDOW_HEIGHT/2 - ROAD_WIDTH/2,
+        WINDOW_WIDTH, ROAD_WIDTH
+    };
+    SDL_RenderFillRect(renderer, &horizontalRoad);
+
+    SDL_Rect verticalRoad = {
+        WINDOW_WIDTH/2 - ROAD_WIDTH/2, 0,
+        ROAD_WIDTH, WINDOW_HEIGHT
+    };
+    SDL_RenderFillRect(renderer, &verticalRoad);
+
+    // Draw zebra crossings with proper alternating pattern
+    int stripeWidth = 10;
+    int crossingWidth = 40;
+
+    for(int i = 0; i < ROAD_WIDTH; i += stripeWidth * 2) {
+        // North zebra
+        SDL_SetRenderDrawColor(renderer, 180, 180, 180, 255); // Less bright white
+        SDL_Rect whiteStripe = {
+            WINDOW_WIDTH/2 - ROAD_WIDTH/2 + i,
+            WINDOW_HEIGHT/2 - ROAD_WIDTH/2 - crossingWidth,
+            stripeWidth,
+            crossingWidth
+        };
+        SDL_RenderFillRect(renderer, &whiteStripe);
+
+        SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255); // Dark gray for contrast
+        SDL_Rect blackStripe = {
+            WINDOW_WIDTH/2 - ROAD_WIDTH/2 + i + stripeWidth,
+            WINDOW_HEIGHT/2 - ROAD_WIDTH/2 - crossingWidth,
+            stripeWidth,
+            crossingWidth
+        };
+        SDL_RenderFillRect(renderer, &blackStripe);
+
+        // South zebra
+        SDL_SetRenderDrawColor(renderer, 180, 180, 180, 255);
+        whiteStripe.y = WINDOW_HEIGHT/2 + ROAD_WIDTH/2;
+        SDL_RenderFillRect(renderer, &whiteStripe);
+
+        SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
+        blackStripe.y = WINDOW_HEIGHT/2 + ROAD_WIDTH/2;
+        SDL_RenderFillRect(renderer, &blackStripe);
+    }
+
+    // East and West zebra crossings
+    for(int i = 0; i < ROAD_WIDTH; i += stripeWidth * 2) {
+        // East zebra
+        SDL_SetRenderDrawColor(renderer, 180, 180, 180, 255);
+        SDL_Rect whiteStripe = {
+            WINDOW_WIDTH/2 + ROAD_WIDTH/2,
+            WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + i,
+            crossingWidth,
+            stripeWidth
+        };
+        SDL_RenderFillRect(renderer, &whiteStripe);
+
+        SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
+        SDL_Rect blackStripe = {
+            WINDOW_WIDTH/2 + ROAD_WIDTH/2,
+            WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + i + stripeWidth,
+            crossingWidth,
+            stripeWidth
+        };
+        SDL_RenderFillRect(renderer, &blackStripe);
+
+        // West zebra
+        SDL_SetRenderDrawColor(renderer, 180, 180, 180, 255);
+        whiteStripe.x = WINDOW_WIDTH/2 - ROAD_WIDTH/2 - crossingWidth;
+        SDL_RenderFillRect(renderer, &whiteStripe);
+
+        SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
+        blackStripe.x = WINDOW_WIDTH/2 - ROAD_WIDTH/2 - crossingWidth;
+        SDL_RenderFillRect(renderer, &blackStripe);
+    }
+
+    // Draw center lane markers (more visible)
+    int dotLength = 15;
+    int dotGap = 25;
+    SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
+
+    // Draw lanes up to zebra crossings
+    for (int i = 1; i < 3; i++) {
+        // North lanes
+        int x = WINDOW_WIDTH/2 - ROAD_WIDTH/2 + i*LANE_WIDTH;
+        for (int y = 0; y < WINDOW_HEIGHT/2 - ROAD_WIDTH/2 - crossingWidth; y += dotLength + dotGap) {
+            SDL_Rect dot = {x - 2, y, 4, dotLength};
+            SDL_RenderFillRect(renderer, &dot);
+        }
+
+        // South lanes
+        for (int y = WINDOW_HEIGHT/2 + ROAD_WIDTH/2 + crossingWidth; y < WINDOW_HEIGHT; y += dotLength + dotGap) {
+            SDL_Rect dot = {x - 2, y, 4, dotLength};
+            SDL_RenderFillRect(renderer, &dot);
+        }
+    }
+
+    // East and West lanes
+    for (int i = 1; i < 3; i++) {
+        int y = WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + i*LANE_WIDTH;
+
+        // East lanes
+        for (int x = WINDOW_WIDTH/2 + ROAD_WIDTH/2 + crossingWidth; x < WINDOW_WIDTH; x += dotLength + dotGap) {
+            SDL_Rect dot = {x, y - 2, dotLength, 4};
+            SDL_RenderFillRect(renderer, &dot);
+        }
+
+        // West lanes
+        for (int x = 0; x < WINDOW_WIDTH/2 - ROAD_WIDTH/2 - crossingWidth; x += dotLength + dotGap) {
+            SDL_Rect dot = {x, y - 2, dotLength, 4};
+            SDL_RenderFillRect(renderer, &dot);
+        }
+    }
+}
+
+// Copies the cached road layer, re-rendering it first if it is stale. Falls
+// back to drawing the roads directly if render targets are unavailable.
+void drawStaticScene(SDL_Renderer* renderer, SceneCache* cache) {
+    if (!cache->valid) {
+        if (!cache->roads) {
+            cache->roads = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
+        }
+        if (cache->roads && SDL_SetRenderTarget(renderer, cache->roads) == 0) {
+            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+            SDL_RenderClear(renderer);
+            drawRoads(renderer);
+            SDL_SetRenderTarget(renderer, NULL);
+            cache->valid = true;
+        }
+    }
+
+    if (cache->valid) {
+        SDL_RenderCopy(renderer, cache->roads, NULL, NULL);
+    } else {
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        SDL_RenderClear(renderer);
+        drawRoads(renderer);
+    }
+}
+
+void drawTrafficLights(SDL_Renderer* renderer, TrafficLight lights[4]) {
+    const int LIGHT_SIZE = 25, BOX_PADDING = 5;
+    for (int i = 0; i < 4; i++) {
+        SDL_SetRenderDrawColor(renderer, 20, 20, 20, 255);
+        SDL_Rect lightBox = {lights[i].x - BOX_PADDING, lights[i].y - BOX_PADDING, LIGHT_SIZE + 2*BOX_PADDING, LIGHT_SIZE + 2*BOX_PADDING};
+        SDL_RenderFillRect(renderer, &lightBox);
+        SDL_SetRenderDrawColor(renderer, 100, 100, 100, 255);
+        SDL_RenderDrawRect(renderer, &lightBox);
+        SDL_SetRenderDrawColor(renderer, lights[i].state ? 0 : 200, lights[i].state ? 200 : 0, 0, 255);
+        SDL_Rect outerGlow = {lights[i].x - 2, lights[i].y - 2, LIGHT_SIZE + 4, LIGHT_SIZE + 4};
+        SDL_RenderFillRect(renderer, &outerGlow);
+        SDL_SetRenderDrawColor(renderer, lights[i].state ? 0 : 255, lights[i].state ? 255 : 0, 0, 255);
+        SDL_Rect lightBulb = {lights[i].x, lights[i].y, LIGHT_SIZE, LIGHT_SIZE};
+        SDL_RenderFillRect(renderer, &lightBulb);
+    }
+}
+
+static bool reserveVehicleRects(SceneCache* cache, int count) {
+    if (count <= cache->rectCapacity) return true;
+    int capacity = cache->rectCapacity ? cache->rectCapacity : 64;
+    while (capacity < count) capacity *= 2;
+    for (int t = 0; t < VEHICLE_TYPES; t++) {
+        SDL_Rect* rects = (SDL_Rect*)realloc(cache->vehicleRects[t], capacity * sizeof(SDL_Rect));
+        if (!rects) return false;
+        cache->vehicleRects[t] = rects;
+    }
+    cache->rectCapacity = capacity;
+    return true;
+}
+
+// alpha is how far rendering is between the previous and current sim step.
+// Rects are grouped by type so each colour is set and filled once per frame.
+void drawVehicles(SDL_Renderer* renderer, SceneCache* cache, const Snapshot* snapshot, float alpha) {
+    if (!reserveVehicleRects(cache, snapshot->vehicleCount)) return;
+
+    for (int t = 0; t < VEHICLE_TYPES; t++) cache->rectCounts[t] = 0;
+    for (int i = 0; i < snapshot->vehicleCount; i++) {
+        const SnapshotVehicle* vehicle = &snapshot->vehicles[i];
+        if (vehicle->type < 0 || vehicle->type >= VEHICLE_TYPES) continue;
+        float x = vehicle->prevX + (vehicle->x - vehicle->prevX) * alpha;
+        float y = vehicle->prevY + (vehicle->y - vehicle->prevY) * alpha;
+        SDL_Rect* rect = &cache->vehicleRects[vehicle->type][cache->rectCounts[vehicle->type]++];
+        rect->x = (int)x - VEHICLE_SIZE/2;
+        rect->y = (int)y - VEHICLE_SIZE/2;
+        rect->w = VEHICLE_SIZE;
+        rect->h = VEHICLE_SIZE;
+    }
+
+    for (int t = 0; t < VEHICLE_TYPES; t++) {
+        if (cache->rectCounts[t] == 0) continue;
+        SDL_Color c = VEHICLE_COLORS[t];
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+        SDL_RenderFillRects(renderer, cache->vehicleRects[t], cache->rectCounts[t]);
+    }
+}
@@ -0,0 +1,57 @@
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "rng.h"
+
+#define PCG_MULTIPLIER 6364136223846793005ULL
+
+void seedRng(Rng* rng, uint64_t seed, uint64_t stream) {
+    rng->state = 0;
+    rng->inc = (stream << 1) | 1u;
+    rngNext(rng);
+    rng->state += seed;
+    rngNext(rng);
+}
+
+uint32_t rngNext(Rng* rng) {
+    uint64_t old = rng->state;
+    rng->state = old * PCG_MULTIPLIER + rng->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+    uint32_t rot = (uint32_t)(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+// Lemire's multiply-shift with rejection, so small bounds carry no modulo bias
+uint32_t rngRange(Rng* rng, uint32_t bound) {
+    if (bound == 0) return 0;
+    uint64_t m = (uint64_t)rngNext(rng) * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (uint64_t)rngNext(rng) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+float rngFloat(Rng* rng) {
+    return (rngNext(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+double rngDouble(Rng* rng) {
+    uint64_t high = rngNext(rng) >> 5, low = rngNext(rng) >> 6;
+    return (high * 67108864.0 + low) * (1.0 / 9007199254740992.0);
+}
+
+uint64_t rngSeedFromClock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t seed = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    return seed ^ ((uint64_t)getpid() << 32);
+}
+
+uint64_t parseSeed(const char* text) {
+    return text ? strtoull(text, NULL, 0) : 0;
+}
@@ -0,0 +1,105 @@
+#include <string.h>
+#include "signal_control.h"
+#include "junction.h"
+
+// Vehicles queued on the road a light controls
+static int lightDemand(const SignalInput* input, int light) {
+    int demand = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        if (lightForDirection(dir) != light) continue;
+        for (int lane = 0; lane < 3; lane++) demand += input->laneSizes[dir * 3 + lane];
+    }
+    return demand;
+}
+
+static int minGreenMs(const SignalInput* input) {
+    return input->cycleMs < CONTROLLER_MIN_GREEN_MS ? input->cycleMs : CONTROLLER_MIN_GREEN_MS;
+}
+
+// The original behaviour: t1 -> t2 -> t3 -> t4, lightCycleMs each
+static int chooseFixed(const SignalInput* input, ControllerState* state) {
+    (void)state;
+    if (input->greenMs < input->cycleMs) return -1;
+    return (input->currentLight + 1) % NUM_LIGHTS;
+}
+
+// Gap-out/max-out actuation: a green ends once its road is empty (after the
+// minimum green) or it has run for CONTROLLER_MAX_GREEN_CYCLES cycles. The
+// next green goes to the first road in rotation order that has vehicles.
+static int chooseActuated(const SignalInput* input, ControllerState* state) {
+    (void)state;
+    if (input->green && input->greenMs < minGreenMs(input)) return -1;
+    bool gapOut = lightDemand(input, input->currentLight) == 0;
+    bool maxOut = input->greenMs >= input->cycleMs * CONTROLLER_MAX_GREEN_CYCLES;
+    if (input->green && !gapOut && !maxOut) return -1;
+
+    for (int step = 1; step <= NUM_LIGHTS; step++) {
+        int light = (input->currentLight + step) % NUM_LIGHTS;
+        if (lightDemand(input, light) > 0) return light;
+    }
+    return input->green ? -1 : (input->currentLight + 1) % NUM_LIGHTS; // Nobody waiting: rest
+}
+
+// Max-pressure: exits are unbounded, so a phase's pressure is just its queue.
+// Switch after the minimum green when another road's queue is strictly longer;
+// ties keep the current green, then favour rotation order.
+static int chooseMaxPressure(const SignalInput* input, ControllerState* state) {
+    (void)state;
+    if (input->green && input->greenMs < minGreenMs(input)) return -1;
+    int best = input->currentLight;
+    int bestPressure = input->green ? lightDemand(input, best) : -1;
+    for (int step = 1; step < NUM_LIGHTS; step++) {
+        int light = (input->currentLight + step) % NUM_LIGHTS;
+        int pressure = lightDemand(input, light);
+        if (pressure > bestPressure) {
+            best = light;
+            bestPressure = pressure;
+        }
+    }
+    return best;
+}
+
+// Fixed rotation with the documented AL2 rule: once road A's centre lane holds
+// more than PRIORITY_LANE_ON vehicles, A stays green until it drops below
+// PRIORITY_LANE_OFF, then the rotation resumes from A. A hold that reaches
+// PRIORITY_MAX_GREEN_CYCLES cycles is cut, and every other road gets its
+// normal green before AL2 can take over again.
+static int choosePriority(const SignalInput* input, ControllerState* state) {
+    if (state->priorityYield > 0) {
+        int next = chooseFixed(input, state);
+        if (next >= 0) state->priorityYield--;
+        return next;
+    }
+    int priorityLight = lightForDirection(DIRECTION_SOUTH);
+    int al2 = input->laneSizes[DIRECTION_SOUTH * 3 + LANE_CENTER];
+    if (!state->priorityActive && al2 > PRIORITY_LANE_ON) state->priorityActive = true;
+    else if (state->priorityActive && al2 < PRIORITY_LANE_OFF) state->priorityActive = false;
+
+    if (!state->priorityActive) return chooseFixed(input, state);
+    if (input->green && input->currentLight == priorityLight &&
+        input->greenMs >= input->cycleMs * PRIORITY_MAX_GREEN_CYCLES) {
+        state->priorityActive = false;
+        state->priorityYield = NUM_LIGHTS - 1; // This switch is the first of the rotation back to A
+        return (priorityLight + 1) % NUM_LIGHTS;
+    }
+    return priorityLight;
+}
+
+static const SignalController CONTROLLERS[CONTROLLER_COUNT] = {
+    [CONTROLLER_FIXED] = {"fixed", chooseFixed, false},
+    [CONTROLLER_ACTUATED] = {"actuated", chooseActuated, true},
+    [CONTROLLER_MAX_PRESSURE] = {"max-pressure", chooseMaxPressure, true},
+    [CONTROLLER_PRIORITY] = {"priority", choosePriority, true},
+};
+
+const SignalController* signalController(ControllerKind kind) {
+    if (kind < 0 || kind >= CONTROLLER_COUNT) return NULL;
+    return &CONTROLLERS[kind];
+}
+
+ControllerKind parseControllerKind(const char* name) {
+    for (int kind = 0; kind < CONTROLLER_COUNT; kind++) {
+        if (strcmp(name, CONTROLLERS[kind].name) == 0) return (ControllerKind)kind;
+    }
+    return CONTROLLER_COUNT;
+}
@@ -0,0 +1,36 @@
+#include <time.h>
+#include "sim_clock.h"
+
+double simClockNowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+void initSimClock(SimClock* clock, double stepMs, double timeScale) {
+    clock->timeScale = timeScale > 0 ? timeScale : 1.0;
+    clock->accumulatorMs = 0;
+    clock->lastMs = simClockNowMs();
+    clock->stepMs = stepMs;
+    clock->droppedSteps = 0;
+}
+
+// Returns how many fixed steps are due since the previous call
+int advanceSimClock(SimClock* clock) {
+    double now = simClockNowMs();
+    clock->accumulatorMs += (now - clock->lastMs) * clock->timeScale;
+    clock->lastMs = now;
+
+    int steps = (int)(clock->accumulatorMs / clock->stepMs);
+    clock->accumulatorMs -= steps * clock->stepMs;
+    if (steps > MAX_STEPS_PER_FRAME) {
+        clock->droppedSteps += steps - MAX_STEPS_PER_FRAME;
+        steps = MAX_STEPS_PER_FRAME;
+    }
+    return steps;
+}
+
+// Fraction of a step left in the accumulator, used to interpolate rendering
+float getSimClockAlpha(const SimClock* clock) {
+    return (float)(clock->accumulatorMs / clock->stepMs);
+}
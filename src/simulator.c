@@ -6,294 +6,121 @@
 #include <unistd.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "queue.h"
+#include "junction.h"
+#include "sim_clock.h"
 #include "traffic_generator.h"
+#include "render.h"
+#include "overlay.h"
+#include "snapshot.h"
+#include "trace.h"
+#include "checkpoint.h"
 
-#define WINDOW_WIDTH 800
-#define WINDOW_HEIGHT 600
-#define ROAD_WIDTH 120
-#define LANE_WIDTH (ROAD_WIDTH/3)
 #define INTERSECTION_SIZE (ROAD_WIDTH * 1.2)
-#define VEHICLE_SIZE 20
+#define FRAME_TIME_MS 16
 
+// State shared with the simulation thread. Only the snapshot buffer and the
+// running flag are touched by both sides.
 typedef struct {
-    int x, y;
-    bool state;
-    const char* label;
-} TrafficLight;
-
-void drawRoads(SDL_Renderer* renderer) {
-    // Road background - Darker gray for better contrast
-    SDL_SetRenderDrawColor(renderer, 40, 40, 40, 255);
-
-    // Main roads
-    SDL_Rect horizontalRoad = {
-        0, WINDOW_HEIGHT/2 - ROAD_WIDTH/2,
-        WINDOW_WIDTH, ROAD_WIDTH
-    };
-    SDL_RenderFillRect(renderer, &horizontalRoad);
-
-    SDL_Rect verticalRoad = {
-        WINDOW_WIDTH/2 - ROAD_WIDTH/2, 0,
-        ROAD_WIDTH, WINDOW_HEIGHT
-    };
-    SDL_RenderFillRect(renderer, &verticalRoad);
-
-    // Draw zebra crossings with proper alternating pattern
-    int stripeWidth = 10;
-    int crossingWidth = 40;
-
-    for(int i = 0; i < ROAD_WIDTH; i += stripeWidth * 2) {
-        // North zebra
-        SDL_SetRenderDrawColor(renderer, 180, 180, 180, 255); // Less bright white
-        SDL_Rect whiteStripe = {
-            WINDOW_WIDTH/2 - ROAD_WIDTH/2 + i,
-            WINDOW_HEIGHT/2 - ROAD_WIDTH/2 - crossingWidth,
-            stripeWidth,
-            crossingWidth
-        };
-        SDL_RenderFillRect(renderer, &whiteStripe);
-
-        SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255); // Dark gray for contrast
-        SDL_Rect blackStripe = {
-            WINDOW_WIDTH/2 - ROAD_WIDTH/2 + i + stripeWidth,
-            WINDOW_HEIGHT/2 - ROAD_WIDTH/2 - crossingWidth,
-            stripeWidth,
-            crossingWidth
-        };
-        SDL_RenderFillRect(renderer, &blackStripe);
-
-        // South zebra
-        SDL_SetRenderDrawColor(renderer, 180, 180, 180, 255);
-        whiteStripe.y = WINDOW_HEIGHT/2 + ROAD_WIDTH/2;
-        SDL_RenderFillRect(renderer, &whiteStripe);
-
-        SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
-        blackStripe.y = WINDOW_HEIGHT/2 + ROAD_WIDTH/2;
-        SDL_RenderFillRect(renderer, &blackStripe);
-    }
-
-    // East and West zebra crossings
-    for(int i = 0; i < ROAD_WIDTH; i += stripeWidth * 2) {
-        // East zebra
-        SDL_SetRenderDrawColor(renderer, 180, 180, 180, 255);
-        SDL_Rect whiteStripe = {
-            WINDOW_WIDTH/2 + ROAD_WIDTH/2,
-            WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + i,
-            crossingWidth,
-            stripeWidth
-        };
-        SDL_RenderFillRect(renderer, &whiteStripe);
-
-        SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
-        SDL_Rect blackStripe = {
-            WINDOW_WIDTH/2 + ROAD_WIDTH/2,
-            WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + i + stripeWidth,
-            crossingWidth,
-            stripeWidth
-        };
-        SDL_RenderFillRect(renderer, &blackStripe);
-
-        // West zebra
-        SDL_SetRenderDrawColor(renderer, 180, 180, 180, 255);
-        whiteStripe.x = WINDOW_WIDTH/2 - ROAD_WIDTH/2 - crossingWidth;
-        SDL_RenderFillRect(renderer, &whiteStripe);
-
-        SDL_SetRenderDrawColor(renderer, 30, 30, 30, 255);
-        blackStripe.x = WINDOW_WIDTH/2 - ROAD_WIDTH/2 - crossingWidth;
-        SDL_RenderFillRect(renderer, &blackStripe);
-    }
-
-    // Draw center lane markers (more visible)
-    int dotLength = 15;
-    int dotGap = 25;
-    SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
+    Junction* junction;
+    Transport* transport;
+    SnapshotBuffer* snapshots;
+    double timeScale;
+    atomic_bool running;
+} SimThread;
+
+static void sleepMs(double ms) {
+    if (ms <= 0) return;
+    struct timespec ts = {(time_t)(ms / 1000), (long)(fmod(ms, 1000.0) * 1e6)};
+    nanosleep(&ts, NULL);
+}
 
-    // Draw lanes up to zebra crossings
-    for (int i = 1; i < 3; i++) {
-        // North lanes
-        int x = WINDOW_WIDTH/2 - ROAD_WIDTH/2 + i*LANE_WIDTH;
-        for (int y = 0; y < WINDOW_HEIGHT/2 - ROAD_WIDTH/2 - crossingWidth; y += dotLength + dotGap) {
-            SDL_Rect dot = {x - 2, y, 4, dotLength};
-            SDL_RenderFillRect(renderer, &dot);
+// Runs the junction at its own fixed rate and publishes a snapshot after each
+// batch of steps, independent of how long the renderer takes to present
+static void* runSimThread(void* arg) {
+    SimThread* sim = (SimThread*)arg;
+    SimClock clock;
+    initSimClock(&clock, SIM_TICK_MS, sim->timeScale);
+
+    while (atomic_load_explicit(&sim->running, memory_order_relaxed)) {
+        // Live transports are only polled once per wake-up; a replayed trace
+        // every step, so records keep their recorded times at any speed
+        bool everyStep = sim->transport->kind == TRANSPORT_REPLAY;
+        int steps = advanceSimClock(&clock);
+        for (int s = 0; s < steps; s++) {
+            stepJunction(sim->junction, s == 0 || everyStep ? sim->transport : NULL);
         }
-
-        // South lanes
-        for (int y = WINDOW_HEIGHT/2 + ROAD_WIDTH/2 + crossingWidth; y < WINDOW_HEIGHT; y += dotLength + dotGap) {
-            SDL_Rect dot = {x - 2, y, 4, dotLength};
-            SDL_RenderFillRect(renderer, &dot);
+        if (steps > 0) {
+            Snapshot* snapshot = beginSnapshot(sim->snapshots);
+            captureSnapshot(snapshot, sim->junction);
+            snapshot->publishedMs = clock.lastMs;
+            snapshot->alpha = getSimClockAlpha(&clock);
+            snapshot->droppedSteps = clock.droppedSteps;
+            publishSnapshot(sim->snapshots);
         }
+        // Sleep until the next step is due
+        sleepMs((clock.stepMs - clock.accumulatorMs) / clock.timeScale);
     }
+    return NULL;
+}
 
-    // East and West lanes
-    for (int i = 1; i < 3; i++) {
-        int y = WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + i*LANE_WIDTH;
-
-        // East lanes
-        for (int x = WINDOW_WIDTH/2 + ROAD_WIDTH/2 + crossingWidth; x < WINDOW_WIDTH; x += dotLength + dotGap) {
-            SDL_Rect dot = {x, y - 2, dotLength, 4};
-            SDL_RenderFillRect(renderer, &dot);
+int main(int argc, char* argv[]) {
+    // Time acceleration: ./simulator --speed 10 runs ten sim steps per 16 ms of real time
+    double timeScale = 1.0;
+    TransportKind transportKind = TRANSPORT_FILE;
+    const char* source = NULL;
+    const char* journeyPath = NULL;
+    const char* fontPath = NULL;
+    const char* restorePath = NULL;
+    bool seedGiven = false;
+    bool controllerGiven = false;
+    bool showOverlay = false;
+    bool fromStart = false;
+    JunctionConfig config;
+    defaultJunctionConfig(&config);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) timeScale = atof(argv[++i]);
+        else if (strcmp(argv[i], "--transport") == 0 && i + 1 < argc) transportKind = parseTransportKind(argv[++i]);
+        else if (strcmp(argv[i], "--source") == 0 && i + 1 < argc) source = argv[++i];
+        else if (strcmp(argv[i], "--from-start") == 0) fromStart = true;
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            transportKind = TRANSPORT_REPLAY;
+            source = argv[++i];
         }
-
-        // West lanes
-        for (int x = 0; x < WINDOW_WIDTH/2 - ROAD_WIDTH/2 - crossingWidth; x += dotLength + dotGap) {
-            SDL_Rect dot = {x, y - 2, dotLength, 4};
-            SDL_RenderFillRect(renderer, &dot);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = parseSeed(argv[++i]);
+            seedGiven = true;
+        }
+        else if (strcmp(argv[i], "--preempt") == 0) config.preemption = true;
+        else if (strcmp(argv[i], "--controller") == 0 && i + 1 < argc) {
+            config.controller = parseControllerKind(argv[++i]);
+            controllerGiven = true;
         }
+        else if (strcmp(argv[i], "--journey-log") == 0 && i + 1 < argc) journeyPath = argv[++i];
+        else if (strcmp(argv[i], "--overlay") == 0) showOverlay = true;
+        else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc) fontPath = argv[++i];
+        else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc) restorePath = argv[++i];
     }
-}
-
-void drawTrafficLights(SDL_Renderer* renderer, TrafficLight lights[4]) {
-    const int LIGHT_SIZE = 25, BOX_PADDING = 5;
-    for (int i = 0; i < 4; i++) {
-        SDL_SetRenderDrawColor(renderer, 20, 20, 20, 255);
-        SDL_Rect lightBox = {lights[i].x - BOX_PADDING, lights[i].y - BOX_PADDING, LIGHT_SIZE + 2*BOX_PADDING, LIGHT_SIZE + 2*BOX_PADDING};
-        SDL_RenderFillRect(renderer, &lightBox);
-        SDL_SetRenderDrawColor(renderer, 100, 100, 100, 255);
-        SDL_RenderDrawRect(renderer, &lightBox);
-        SDL_SetRenderDrawColor(renderer, lights[i].state ? 0 : 200, lights[i].state ? 200 : 0, 0, 255);
-        SDL_Rect outerGlow = {lights[i].x - 2, lights[i].y - 2, LIGHT_SIZE + 4, LIGHT_SIZE + 4};
-        SDL_RenderFillRect(renderer, &outerGlow);
-        SDL_SetRenderDrawColor(renderer, lights[i].state ? 0 : 255, lights[i].state ? 255 : 0, 0, 255);
-        SDL_Rect lightBulb = {lights[i].x, lights[i].y, LIGHT_SIZE, LIGHT_SIZE};
-        SDL_RenderFillRect(renderer, &lightBulb);
+    if (timeScale <= 0) {
+        fprintf(stderr, "Time scale must be positive\n");
+        return 1;
     }
-}
-
-void drawVehicles(SDL_Renderer* renderer, Queue* queues[]) {
-    for (int i = 0; i < 12; i++) {
-        Queue* queue = queues[i];
-        for (int j = 0; j < queue->size; j++) {
-            Vehicle* vehicle = queue->items[(queue->front + j) % MAX_QUEUE_SIZE];
-            if (!vehicle) continue;
-            switch(vehicle->type) {
-                case 0: SDL_SetRenderDrawColor(renderer, 30, 144, 255, 255); break;
-                case 1: SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255); break;
-                case 2: SDL_SetRenderDrawColor(renderer, 0, 0, 139, 255); break;
-                case 3: SDL_SetRenderDrawColor(renderer, 255, 140, 0, 255); break;
-            }
-            SDL_Rect vehicleRect = {(int)vehicle->x - VEHICLE_SIZE/2, (int)vehicle->y - VEHICLE_SIZE/2, VEHICLE_SIZE, VEHICLE_SIZE};
-            SDL_RenderFillRect(renderer, &vehicleRect);
-        }
+    if (config.controller == CONTROLLER_COUNT) {
+        fprintf(stderr, "Unknown controller; use fixed, actuated, max-pressure or priority\n");
+        return 1;
     }
-}
-
-void updateVehiclePositions(Queue* queues[], bool lightStates[]) {
-    for (int i = 0; i < 12; i++) {
-        Queue* queue = queues[i];
-        if (isEmpty(queue)) continue;
-        int direction = i / 3; // 0=A, 1=B, 2=C, 3=D
-        int lane = i % 3;
-
-        for (int j = 0; j < queue->size; j++) {
-            Vehicle* vehicle = queue->items[(queue->front + j) % MAX_QUEUE_SIZE];
-            if (!vehicle) continue;
-
-            // Determine lane offset
-            float laneOffset;
-            if (direction == 1 || direction == 3) {
-                laneOffset = ((2 - lane) + 0.5) * LANE_WIDTH;
-            } else {
-                laneOffset = (lane + 0.5) * LANE_WIDTH;
-            }
-
-            // Set vehicle position based on direction
-            switch (direction) {
-                case 0: vehicle->x = WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 + laneOffset; break; // A
-                case 1: vehicle->y = WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 + laneOffset; break; // B
-                case 2: vehicle->y = WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 + laneOffset; break; // C
-                case 3: vehicle->x = WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 + laneOffset; break; // D
-            }
-
-            // Check if vehicle is at the zebra crossing
-            bool atZebra = false, pastIntersection = false;
-            switch (direction) {
-                case 0: // A (Southbound)
-                    atZebra = vehicle->y >= WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2 - 40 && vehicle->y < WINDOW_HEIGHT / 2;
-                    break;
-                case 1: // B (Westbound)
-                    atZebra = vehicle->x >= WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 - 40 && vehicle->x < WINDOW_WIDTH / 2;
-                    break;
-                case 2: // C (Eastbound)
-                    atZebra = vehicle->x <= WINDOW_WIDTH / 2 + ROAD_WIDTH / 2 + 40 && vehicle->x > WINDOW_WIDTH / 2;
-                    pastIntersection = vehicle->x > WINDOW_WIDTH / 2;
-                    break;
-                case 3: // D (Northbound)
-                    atZebra = vehicle->y <= WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 + 40 && vehicle->y > WINDOW_HEIGHT / 2;
-                    pastIntersection = vehicle->y < WINDOW_HEIGHT / 2;
-                    break;
-            }
-
-            // Determine if the vehicle can proceed through the intersection
-            bool canMove = canProceedThroughIntersection(vehicle, lightStates);
-            Vehicle* ahead = (j > 0) ? queue->items[(queue->front + j - 1) % MAX_QUEUE_SIZE] : NULL;
-            if (ahead && !isSafeDistance(vehicle, ahead)) canMove = false;
-
-            // Stop at zebra crossing if light is red (unless past intersection or emergency)
-            if (atZebra && !pastIntersection && !canMove) {
-                vehicle->waitTime++;
-                switch (direction) {
-                    case 0: vehicle->y = WINDOW_HEIGHT / 2 + ROAD_WIDTH / 2 + 5; break; // A
-                    case 1: vehicle->x = WINDOW_WIDTH / 2 - ROAD_WIDTH / 2 - 5; break; // B
-                    case 2: vehicle->x = WINDOW_WIDTH / 2 + ROAD_WIDTH / 2 + 5; break; // C
-                    case 3: vehicle->y = WINDOW_HEIGHT / 2 - ROAD_WIDTH / 2 - 5; break; // D
-                }
-                continue; // Skip further movement logic
-            }
-
-            // Update vehicle position if allowed to move
-            if (canMove) {
-                updateVehiclePosition(vehicle);
-            } else {
-                vehicle->waitTime++;
-            }
-
-            // Check if the vehicle should be dequeued and moved to the next queue
-            bool shouldDequeue = false;
-            switch (direction) {
-                case 0: shouldDequeue = vehicle->y < -VEHICLE_SIZE; break; // A
-                case 1: shouldDequeue = vehicle->x < -VEHICLE_SIZE; break; // B
-                case 2: shouldDequeue = vehicle->x > WINDOW_WIDTH + VEHICLE_SIZE; break; // C
-                case 3: shouldDequeue = vehicle->y > WINDOW_HEIGHT + VEHICLE_SIZE; break; // D
-            }
-            if (shouldDequeue) {
-                int nextQueueIndex = vehicle->endDirection * 3 + vehicle->endLane;
-                if (nextQueueIndex >= 0 && nextQueueIndex < 12) enqueue(queues[nextQueueIndex], vehicle);
-                else free(vehicle);
-                dequeue(queue);
-            }
-        }
+    if (transportKind == TRANSPORT_COUNT) {
+        fprintf(stderr, "Unknown transport; use file, shm, socket or replay\n");
+        return 1;
     }
-}
+    if (transportKind == TRANSPORT_FILE && !source) source = "vehicles.txt";
+    if (transportKind == TRANSPORT_REPLAY) config.spawner = false;
 
-void processVehiclesFromFile(Queue* queues[], const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) return;
-    char line[256];
-    while (fgets(line, sizeof(line), file)) {
-        Vehicle* vehicle = (Vehicle*)malloc(sizeof(Vehicle));
-        if (!vehicle) continue;
-        int turning, passed;
-        int startDir, endDir, startLane, endLane; // Use ints for sscanf
-        sscanf(line, "%d,%d,%d,%d,%d,%d,%f,%f,%f,%f,%d,%f,%d,%d",
-            &vehicle->vehicleId, &vehicle->type, &startDir, &endDir,
-            &startLane, &endLane, &vehicle->x, &vehicle->y, &vehicle->speed,
-            &vehicle->turnAngle, &turning, &vehicle->progress, &vehicle->waitTime, &passed);
-        vehicle->startDirection = (Direction)startDir; // Cast to Direction
-        vehicle->endDirection = (Direction)endDir;     // Cast to Direction
-        vehicle->startLane = (LanePosition)startLane;  // Cast to LanePosition
-        vehicle->endLane = (LanePosition)endLane;      // Cast to LanePosition
-        vehicle->turning = turning;
-        vehicle->passedIntersection = passed;
-        int queueIndex = vehicle->startDirection * 3 + vehicle->startLane;
-        if (queueIndex >= 0 && queueIndex < 12) enqueue(queues[queueIndex], vehicle);
-        else free(vehicle);
-    }
-    fclose(file);
-    truncate(filename, 0);
-}
+    Transport transport;
+    if (!openTransport(&transport, transportKind, source, fromStart)) return 1;
 
-int main() {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
         return 1;
@@ -304,7 +131,7 @@ int main() {
         SDL_Quit();
         return 1;
     }
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
     if (!renderer) {
         fprintf(stderr, "Renderer creation failed: %s\n", SDL_GetError());
         SDL_DestroyWindow(window);
@@ -319,112 +146,102 @@ int main() {
         {470, 370, false, "t4"}  // t4 (Southeast corner)
     };
 
-    Queue* queues[12];
-    for (int dir = 0; dir < 4; dir++) {
-        for (int lane = 0; lane < 3; lane++) {
-            queues[dir * 3 + lane] = createQueue(dir, lane);
-        }
+    // A restored junction brings its own config, with the same overrides as headless
+    Junction* junction = restorePath ? restoreJunction(restorePath) : createJunction(&config);
+    if (junction && restorePath) applyRestoreOverrides(junction, &config, seedGiven, controllerGiven);
+    if (!junction) {
+        if (restorePath) fprintf(stderr, "Restoring %s failed\n", restorePath);
+        else fprintf(stderr, "Junction creation failed\n");
+        closeTransport(&transport);
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+    if (journeyPath && !(junction->journeyLog = openJourneyLog(journeyPath, SIM_TICK_MS))) {
+        perror(journeyPath); // Keep running without trip records
     }
 
-    srand(time(NULL));
-    bool lightStates[4] = {false, false, false, false}; // All red initially
-    int currentLight = 0, lightTimer = 0;
-    const int LIGHT_CYCLE_TIME = 5000; // 5 seconds
+    SnapshotBuffer snapshots;
+    if (!initSnapshotBuffer(&snapshots, junction->pool->capacity)) {
+        fprintf(stderr, "Snapshot buffer allocation failed\n");
+        closeJourneyLog(junction->journeyLog);
+        destroyJunction(junction);
+        closeTransport(&transport);
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
 
-    int vehicleGenTimer = 0, VEHICLE_GEN_INTERVAL = 20;
+    SceneCache scene;
+    initSceneCache(&scene);
+
+    // F1 toggles the telemetry overlay; it stays off if the font can't be loaded
+    Overlay overlay;
+    if (initOverlay(&overlay, fontPath, OVERLAY_FONT_SIZE)) overlay.visible = showOverlay;
+
+    TRACE_INIT(TRACE_DEFAULT_PATH);
+    SimThread sim = {junction, &transport, &snapshots, timeScale};
+    atomic_init(&sim.running, true);
+    pthread_t simThread;
+    bool started = pthread_create(&simThread, NULL, runSimThread, &sim) == 0;
+    if (!started) {
+        fprintf(stderr, "Simulation thread creation failed\n");
+        atomic_store(&sim.running, false); // Skips the render loop; the teardown below is shared
+    }
 
-    bool running = true;
+    // From here on this thread only reads snapshots; the junction belongs to
+    // the simulation thread until it is joined
+    bool running = atomic_load(&sim.running);
     while (running) {
+        TRACE_SCOPE("frame");
+        TRACE_POLL();
+        double frameStart = simClockNowMs();
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) running = false;
-        }
-
-        int queueLengths[4] = {0};
-        for (int i = 0; i < 4; i++) {
-            for (int j = 0; j < 3; j++) queueLengths[i] += getSize(queues[i*3 + j]);
-        }
-
-        processVehiclesFromFile(queues, "vehicles.txt");
-
-        vehicleGenTimer++;
-        if (vehicleGenTimer >= VEHICLE_GEN_INTERVAL) {
-            vehicleGenTimer = 0;
-            for (int dir = 0; dir < 4; dir++) {
-                if (queueLengths[dir] < 8) {
-                    int lane = rand() % 2; // Lane 0 (Left) or Lane 1 (Center)
-                    Vehicle* vehicle = malloc(sizeof(Vehicle));
-                    if (vehicle) {
-                        vehicle->vehicleId = rand();
-                        vehicle->type = (rand() % 100 < 90) ? 0 : (1 + rand() % 3);
-                        vehicle->startDirection = dir;
-                        vehicle->startLane = lane;
-                        vehicle->speed = 2.0f + (rand() % 15) / 10.0f; // Faster speed
-                        float laneOffset;
-                        if (dir == 2 || dir == 3) { 
-                            laneOffset = ((2 - lane) + 0.5) * LANE_WIDTH;
-                        } else {
-                            laneOffset = (lane + 0.5) * LANE_WIDTH;
-                        }
-                        switch(dir) {
-                            case 0: // A (Southbound)
-                                vehicle->x = WINDOW_WIDTH/2 - ROAD_WIDTH/2 + laneOffset;
-                                vehicle->y = WINDOW_HEIGHT + VEHICLE_SIZE;
-                                break;
-                            case 1: // B (Westbound)
-                                vehicle->x = WINDOW_WIDTH + VEHICLE_SIZE;
-                                vehicle->y = WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + laneOffset;
-                                break;
-                            case 2: // C (Eastbound)
-                                vehicle->x = -VEHICLE_SIZE;
-                                vehicle->y = WINDOW_HEIGHT/2 - ROAD_WIDTH/2 + laneOffset;
-                                break;
-                            case 3: // D (Northbound)
-                                vehicle->x = WINDOW_WIDTH/2 - ROAD_WIDTH/2 + laneOffset;
-                                vehicle->y = -VEHICLE_SIZE;
-                                break;
-                        }
-                        vehicle->turning = false;
-                        vehicle->turnAngle = 0.0f;
-                        vehicle->progress = 0.0f;
-                        vehicle->waitTime = 0;
-                        vehicle->passedIntersection = false;
-                        setVehiclePath(vehicle);
-                        enqueue(queues[dir * 3 + lane], vehicle);
-                    }
-                }
+            if ((event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) ||
+                event.type == SDL_RENDER_TARGETS_RESET) {
+                invalidateSceneCache(&scene);
+                invalidateOverlay(&overlay);
             }
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F1) overlay.visible = !overlay.visible;
         }
 
-        updateVehiclePositions(queues, lightStates);
+        const Snapshot* snapshot = latestSnapshot(&snapshots);
+        for (int i = 0; i < 4; i++) lights[i].state = snapshot->lightStates[i];
 
-        lightTimer += 16; // Increment by frame delay (16ms ~ 60 FPS)
-        if (lightTimer >= LIGHT_CYCLE_TIME) {
-            lightTimer = 0;
-            lightStates[currentLight] = false;
-            currentLight = (currentLight + 1) % 4; // Cycle: t1 -> t2 -> t3 -> t4
-            lightStates[currentLight] = true;
-            for (int i = 0; i < 4; i++) lights[i].state = lightStates[i];
+        {
+            TRACE_SCOPE("draw");
+            drawStaticScene(renderer, &scene);
+            drawTrafficLights(renderer, lights);
+            drawVehicles(renderer, &scene, snapshot, snapshotAlpha(snapshot, frameStart, timeScale));
+            updateOverlay(&overlay, snapshot, timeScale, frameStart);
+            drawOverlay(renderer, &overlay, lights);
         }
-
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-        SDL_RenderClear(renderer);
-        drawRoads(renderer);
-        drawTrafficLights(renderer, lights);
-        drawVehicles(renderer, queues);
-        SDL_RenderPresent(renderer);
-        SDL_Delay(16);
-    }
-
-    for (int i = 0; i < 12; i++) {
-        while (!isEmpty(queues[i])) {
-            Vehicle* vehicle = dequeue(queues[i]);
-            if (vehicle) free(vehicle);
+        {
+            TRACE_SCOPE("present");
+            SDL_RenderPresent(renderer);
         }
-        free(queues[i]);
+
+        // Cap the frame rate only; simulation time is kept by the sim thread
+        double frameTime = simClockNowMs() - frameStart;
+        recordOverlayFrame(&overlay, frameTime);
+        if (frameTime < FRAME_TIME_MS) SDL_Delay((Uint32)(FRAME_TIME_MS - frameTime));
     }
+    if (atomic_exchange(&sim.running, false)) pthread_join(simThread, NULL);
+    TRACE_SHUTDOWN();
+
+    destroyOverlay(&overlay);
+    destroySceneCache(&scene);
+    destroySnapshotBuffer(&snapshots);
+    closeJourneyLog(junction->journeyLog);
+    destroyJunction(junction);
+    if (transport.server) printSocketClients(transport.server, stdout);
+    closeTransport(&transport);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
-    return 0;
+    return started ? 0 : 1;
 }
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+#include "trace.h"
+
+bool initSnapshot(Snapshot* snapshot, int vehicleCapacity) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->vehicles = (SnapshotVehicle*)malloc(sizeof(SnapshotVehicle) * vehicleCapacity);
+    if (!snapshot->vehicles) return false;
+    snapshot->vehicleCapacity = vehicleCapacity;
+    return true;
+}
+
+void destroySnapshot(Snapshot* snapshot) {
+    free(snapshot->vehicles);
+    snapshot->vehicles = NULL;
+    snapshot->vehicleCapacity = 0;
+}
+
+// Copies what the renderer needs; the vehicles come out in queue order, which
+// is the order drawVehicles used to walk them in
+void captureSnapshot(Snapshot* snapshot, const Junction* junction) {
+    TRACE_SCOPE("capture");
+    snapshot->tick = junction->tick;
+    for (int i = 0; i < NUM_LIGHTS; i++) snapshot->lightStates[i] = junction->lightStates[i];
+    snapshot->backpressured = 0;
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        snapshot->queueSizes[i] = junction->queues[i]->size;
+        snapshot->waitingTimes[i] = junction->queues[i]->waitingTime;
+        snapshot->backpressured += junction->queues[i]->backpressured;
+    }
+    snapshot->drops = countQueueDrops(junction);
+    snapshot->poolInUse = junction->pool->inUse;
+    snapshot->poolCapacity = junction->pool->capacity;
+    snapshot->poolHighWater = junction->pool->highWater;
+    snapshot->poolExhausted = junction->pool->exhausted;
+    snapshot->vehiclesExited = junction->vehiclesExited;
+    snapshot->conflictsAvoided = junction->conflictsAvoided;
+
+    int count = 0;
+    for (int i = 0; i < NUM_QUEUES; i++) {
+        Queue* queue = junction->queues[i];
+        for (int j = 0; j < queue->size && count < snapshot->vehicleCapacity; j++) {
+            Vehicle* vehicle = queueAt(queue, j);
+            if (!vehicle) continue;
+            SnapshotVehicle* out = &snapshot->vehicles[count++];
+            out->x = vehicle->x;
+            out->y = vehicle->y;
+            out->prevX = vehicle->prevX;
+            out->prevY = vehicle->prevY;
+            out->type = vehicle->type;
+        }
+    }
+    snapshot->vehicleCount = count;
+}
+
+// Interpolation factor for drawing at nowMs: the clock's leftover fraction at
+// publish time plus however much sim time has passed since, capped at the
+// newest position so vehicles never run ahead of the model
+float snapshotAlpha(const Snapshot* snapshot, double nowMs, double timeScale) {
+    if (snapshot->tick == 0) return 1.0f;
+    double alpha = snapshot->alpha + (nowMs - snapshot->publishedMs) * timeScale / SIM_TICK_MS;
+    if (alpha < 0) return 0.0f;
+    return alpha > 1 ? 1.0f : (float)alpha;
+}
+
+bool initSnapshotBuffer(SnapshotBuffer* buffer, int vehicleCapacity) {
+    for (int i = 0; i < 3; i++) {
+        if (!initSnapshot(&buffer->slots[i], vehicleCapacity)) {
+            while (i-- > 0) destroySnapshot(&buffer->slots[i]);
+            return false;
+        }
+    }
+    buffer->front = 0;
+    atomic_init(&buffer->middle, 1);
+    buffer->back = 2;
+    buffer->published = 0;
+    buffer->consumed = 0;
+    return true;
+}
+
+void destroySnapshotBuffer(SnapshotBuffer* buffer) {
+    for (int i = 0; i < 3; i++) destroySnapshot(&buffer->slots[i]);
+}
+
+// Writer side: the slot to fill. It stays private to the writer until published.
+Snapshot* beginSnapshot(SnapshotBuffer* buffer) {
+    return &buffer->slots[buffer->back];
+}
+
+void publishSnapshot(SnapshotBuffer* buffer) {
+    int previous = atomic_exchange_explicit(&buffer->middle, buffer->back | SNAPSHOT_FRESH,
+        memory_order_acq_rel);
+    buffer->back = previous & ~SNAPSHOT_FRESH;
+    buffer->published++;
+}
+
+// Reader side: the newest published snapshot, valid until the next call
+const Snapshot* latestSnapshot(SnapshotBuffer* buffer) {
+    if (atomic_load_explicit(&buffer->middle, memory_order_relaxed) & SNAPSHOT_FRESH) {
+        int previous = atomic_exchange_explicit(&buffer->middle, buffer->front, memory_order_acq_rel);
+        buffer->front = previous & ~SNAPSHOT_FRESH;
+        buffer->consumed++;
+    }
+    return &buffer->slots[buffer->front];
+}
@@ -0,0 +1,286 @@
+#define _GNU_SOURCE // accept4
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "socket_ingest.h"
+#include "trace.h"
+
+#define MAX_EPOLL_EVENTS 64
+#define LISTEN_TAG UINT64_MAX        // epoll data for the listening socket
+#define STOP_TAG (UINT64_MAX - 1)    // ... and for the stop eventfd
+
+static uint64_t monotonicNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void dropClient(SocketIngest* ingest, SocketClient* client) {
+    epoll_ctl(ingest->epollFd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    client->fd = -1;
+    client->buffered = 0;
+    atomic_store_explicit(&client->lastNs, monotonicNs(), memory_order_relaxed);
+    atomic_store(&client->open, false);
+    atomic_fetch_sub_explicit(&ingest->connected, 1, memory_order_relaxed);
+}
+
+// A never-used slot if there is one, else the one whose client left first
+static SocketClient* freeSlot(SocketIngest* ingest) {
+    SocketClient* oldest = NULL;
+    for (int i = 0; i < SOCKET_INGEST_MAX_CLIENTS; i++) {
+        SocketClient* client = &ingest->clients[i];
+        if (!atomic_load(&client->used)) return client;
+        if (client->fd < 0 && (!oldest || atomic_load(&client->lastNs) < atomic_load(&oldest->lastNs))) oldest = client;
+    }
+    return oldest;
+}
+
+static void acceptClients(SocketIngest* ingest) {
+    int fd;
+    while ((fd = accept4(ingest->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        SocketClient* client = freeSlot(ingest);
+        if (!client) {
+            atomic_fetch_add_explicit(&ingest->rejected, 1, memory_order_relaxed);
+            close(fd);
+            continue;
+        }
+        int index = (int)(client - ingest->clients);
+        struct epoll_event event = {.events = EPOLLIN | EPOLLRDHUP, .data.u64 = (uint64_t)index};
+        if (epoll_ctl(ingest->epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        uint64_t now = monotonicNs();
+        client->fd = fd;
+        client->buffered = 0;
+        atomic_store(&client->id, ingest->nextId++);
+        atomic_store(&client->connectedNs, now);
+        atomic_store(&client->lastNs, now);
+        atomic_store(&client->batches, 0);
+        atomic_store(&client->received, 0);
+        atomic_store(&client->dropped, 0);
+        atomic_store(&client->protocolErrors, 0);
+        atomic_store(&client->open, true);
+        atomic_store(&client->used, true);
+        atomic_fetch_add_explicit(&ingest->accepted, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&ingest->connected, 1, memory_order_relaxed);
+    }
+}
+
+// Decodes one complete batch into the ring. A full ring drops records rather
+// than stalling every other client behind this one.
+static void admitBatch(SocketIngest* ingest, SocketClient* client, const TraceRecord* records, uint32_t count) {
+    long received = 0, dropped = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        TraceRecord record;
+        memcpy(&record, &records[i], sizeof(record));
+        int startLane = (record.route >> 2) & 3, endLane = (record.route >> 6) & 3;
+        Vehicle* slot = startLane < 3 && endLane < 3 ? reserveVehicleSlot(ingest->ring) : NULL;
+        if (!slot) {
+            dropped++;
+            continue;
+        }
+        decodeTraceRecord(&record, slot);
+        publishVehicleSlot(ingest->ring);
+        received++;
+    }
+    atomic_fetch_add_explicit(&client->batches, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&client->received, received, memory_order_relaxed);
+    atomic_fetch_add_explicit(&client->dropped, dropped, memory_order_relaxed);
+    atomic_store_explicit(&client->lastNs, monotonicNs(), memory_order_relaxed);
+}
+
+// One read per wake-up keeps a busy client from starving the others; epoll
+// is level-triggered, so whatever is left brings us straight back.
+static void readClient(SocketIngest* ingest, SocketClient* client) {
+    TRACE_SCOPE("socket_ingest");
+    ssize_t n = recv(client->fd, client->buffer + client->buffered, sizeof(client->buffer) - client->buffered, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        dropClient(ingest, client);
+        return;
+    }
+    if (n < 0) return;
+    client->buffered += (size_t)n;
+
+    size_t offset = 0;
+    while (client->buffered - offset >= sizeof(SocketBatchHeader)) {
+        SocketBatchHeader header;
+        memcpy(&header, client->buffer + offset, sizeof(header));
+        if (header.magic != SOCKET_BATCH_MAGIC || header.count > SOCKET_BATCH_MAX) {
+            atomic_fetch_add_explicit(&client->protocolErrors, 1, memory_order_relaxed);
+            dropClient(ingest, client);
+            return;
+        }
+        size_t frame = sizeof(header) + header.count * sizeof(TraceRecord);
+        if (client->buffered - offset < frame) break;
+        admitBatch(ingest, client, (const TraceRecord*)(client->buffer + offset + sizeof(header)), header.count);
+        offset += frame;
+    }
+    client->buffered -= offset;
+    memmove(client->buffer, client->buffer + offset, client->buffered);
+}
+
+static void* serverMain(void* arg) {
+    SocketIngest* ingest = (SocketIngest*)arg;
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    while (!atomic_load_explicit(&ingest->stopping, memory_order_relaxed)) {
+        int n = epoll_wait(ingest->epollFd, events, MAX_EPOLL_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == STOP_TAG) return NULL;
+            if (tag == LISTEN_TAG) {
+                acceptClients(ingest);
+                continue;
+            }
+            SocketClient* client = &ingest->clients[tag];
+            if (client->fd < 0) continue; // Dropped earlier in this batch of events
+            if (events[i].events & EPOLLIN) readClient(ingest, client);
+            else dropClient(ingest, client); // Hang-up or error with nothing left to read
+        }
+    }
+    return NULL;
+}
+
+SocketIngest* openSocketIngest(const char* path) {
+    SocketIngest* ingest = (SocketIngest*)calloc(1, sizeof(SocketIngest));
+    if (!ingest) return NULL;
+    ingest->listenFd = -1;
+    ingest->epollFd = -1;
+    ingest->stopFd = -1;
+    for (int i = 0; i < SOCKET_INGEST_MAX_CLIENTS; i++) ingest->clients[i].fd = -1;
+    atomic_init(&ingest->stopping, false);
+
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        free(ingest);
+        return NULL;
+    }
+    snprintf(ingest->path, sizeof(ingest->path), "%s", path);
+    memcpy(address.sun_path, ingest->path, sizeof(ingest->path));
+    // A stale socket from an earlier run is replaced; anything else at the path is left alone
+    struct stat existing;
+    if (lstat(ingest->path, &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            fprintf(stderr, "%s exists and is not a socket\n", ingest->path);
+            free(ingest);
+            return NULL;
+        }
+        unlink(ingest->path);
+    }
+
+    ingest->ring = createLocalVehicleRing(SOCKET_INGEST_RING_CAPACITY);
+    ingest->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ingest->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    ingest->stopFd = eventfd(0, EFD_CLOEXEC);
+    struct epoll_event listenEvent = {.events = EPOLLIN, .data.u64 = LISTEN_TAG};
+    struct epoll_event stopEvent = {.events = EPOLLIN, .data.u64 = STOP_TAG};
+    if (!ingest->ring || ingest->listenFd < 0 || ingest->epollFd < 0 || ingest->stopFd < 0 ||
+        bind(ingest->listenFd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(ingest->listenFd, SOMAXCONN) != 0 ||
+        epoll_ctl(ingest->epollFd, EPOLL_CTL_ADD, ingest->listenFd, &listenEvent) != 0 ||
+        epoll_ctl(ingest->epollFd, EPOLL_CTL_ADD, ingest->stopFd, &stopEvent) != 0) {
+        perror(ingest->path);
+        closeSocketIngest(ingest);
+        return NULL;
+    }
+    if (pthread_create(&ingest->thread, NULL, serverMain, ingest) != 0) {
+        closeSocketIngest(ingest);
+        return NULL;
+    }
+    ingest->threadStarted = true;
+    return ingest;
+}
+
+void closeSocketIngest(SocketIngest* ingest) {
+    if (!ingest) return;
+    if (ingest->threadStarted) {
+        atomic_store(&ingest->stopping, true);
+        uint64_t one = 1;
+        if (write(ingest->stopFd, &one, sizeof(one)) < 0) perror("socket ingest stop");
+        pthread_join(ingest->thread, NULL);
+    }
+    for (int i = 0; i < SOCKET_INGEST_MAX_CLIENTS; i++) {
+        if (ingest->clients[i].fd >= 0) close(ingest->clients[i].fd);
+    }
+    if (ingest->listenFd >= 0) {
+        close(ingest->listenFd);
+        unlink(ingest->path);
+    }
+    if (ingest->epollFd >= 0) close(ingest->epollFd);
+    if (ingest->stopFd >= 0) close(ingest->stopFd);
+    closeVehicleRing(ingest->ring);
+    free(ingest);
+}
+
+// One line per connection still holding a slot
+void printSocketClients(const SocketIngest* ingest, FILE* out) {
+    fprintf(out, "socket clients:     %ld accepted, %d connected, %ld rejected\n",
+        atomic_load(&ingest->accepted), atomic_load(&ingest->connected), atomic_load(&ingest->rejected));
+    uint64_t now = monotonicNs();
+    for (int i = 0; i < SOCKET_INGEST_MAX_CLIENTS; i++) {
+        const SocketClient* client = &ingest->clients[i];
+        if (!atomic_load(&client->used)) continue;
+        bool open = atomic_load(&client->open);
+        uint64_t end = open ? now : atomic_load(&client->lastNs);
+        double seconds = (end - atomic_load(&client->connectedNs)) / 1e9;
+        long received = atomic_load(&client->received);
+        fprintf(out, "  client %-3d %-6s %8ld received %6ld dropped %6ld batches %9.1f veh/s%s\n",
+            atomic_load(&client->id), open ? "open" : "closed", received, atomic_load(&client->dropped),
+            atomic_load(&client->batches), seconds > 0 ? received / seconds : 0.0,
+            atomic_load(&client->protocolErrors) ? "  (protocol error)" : "");
+    }
+}
+
+int connectVehicleSocket(const char* path) {
+    struct sockaddr_un address = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(address.sun_path)) return -1;
+    memcpy(address.sun_path, path, strlen(path) + 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Sends vehicles as one or more length-prefixed batches; false once the
+// server has gone away
+bool sendVehicleBatch(int fd, const Vehicle* vehicles, int count) {
+    uint8_t frame[sizeof(SocketBatchHeader) + SOCKET_BATCH_MAX * sizeof(TraceRecord)];
+    while (count > 0) {
+        int n = count < SOCKET_BATCH_MAX ? count : SOCKET_BATCH_MAX;
+        SocketBatchHeader header = {SOCKET_BATCH_MAGIC, (uint32_t)n};
+        memcpy(frame, &header, sizeof(header));
+        for (int i = 0; i < n; i++) {
+            TraceRecord record;
+            encodeTraceRecord(&vehicles[i], 0, &record);
+            memcpy(frame + sizeof(header) + i * sizeof(record), &record, sizeof(record));
+        }
+        size_t length = sizeof(header) + n * sizeof(TraceRecord);
+        for (size_t sent = 0; sent < length; ) {
+            ssize_t w = send(fd, frame + sent, length - sent, MSG_NOSIGNAL);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) return false;
+            sent += (size_t)w;
+        }
+        vehicles += n;
+        count -= n;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#include <stdlib.h>
+#include "spatial_grid.h"
+#include "traffic_generator.h"
+
+SpatialGrid* createSpatialGrid(int capacity) {
+    SpatialGrid* grid = (SpatialGrid*)calloc(1, sizeof(SpatialGrid));
+    if (!grid) return NULL;
+    grid->cols = (WINDOW_WIDTH + 2 * GRID_MARGIN) / GRID_CELL_SIZE + 1;
+    grid->rows = (WINDOW_HEIGHT + 2 * GRID_MARGIN) / GRID_CELL_SIZE + 1;
+    grid->capacity = capacity;
+    int cells = grid->cols * grid->rows;
+    grid->cellHead = (int*)malloc(cells * sizeof(int));
+    grid->usedCells = (int*)malloc(capacity * sizeof(int));
+    grid->entries = (GridEntry*)malloc(capacity * sizeof(GridEntry));
+    if (!grid->cellHead || !grid->usedCells || !grid->entries) {
+        destroySpatialGrid(grid);
+        return NULL;
+    }
+    for (int c = 0; c < cells; c++) grid->cellHead[c] = -1;
+    return grid;
+}
+
+void destroySpatialGrid(SpatialGrid* grid) {
+    if (!grid) return;
+    free(grid->cellHead);
+    free(grid->usedCells);
+    free(grid->entries);
+    free(grid);
+}
+
+// Clamps to the border cells, so anything off the grid still lands somewhere
+static int cellOf(const SpatialGrid* grid, float x, float y) {
+    int cx = (int)((x + GRID_MARGIN) / GRID_CELL_SIZE);
+    int cy = (int)((y + GRID_MARGIN) / GRID_CELL_SIZE);
+    if (cx < 0) cx = 0;
+    if (cx >= grid->cols) cx = grid->cols - 1;
+    if (cy < 0) cy = 0;
+    if (cy >= grid->rows) cy = grid->rows - 1;
+    return cy * grid->cols + cx;
+}
+
+void rebuildSpatialGrid(SpatialGrid* grid, Queue* queues[], int queueCount) {
+    for (int u = 0; u < grid->usedCount; u++) grid->cellHead[grid->usedCells[u]] = -1;
+    grid->usedCount = 0;
+
+    int total = 0;
+    for (int q = 0; q < queueCount; q++) {
+        for (int j = 0; j < queues[q]->size && total < grid->capacity; j++, total++) {
+            Vehicle* v = queueAt(queues[q], j);
+            int cell = cellOf(grid, v->x, v->y);
+            if (grid->cellHead[cell] < 0) grid->usedCells[grid->usedCount++] = cell;
+            GridEntry* entry = &grid->entries[total];
+            entry->vehicle = v;
+            entry->queueIndex = q;
+            entry->next = grid->cellHead[cell];
+            grid->cellHead[cell] = total;
+        }
+    }
+    grid->count = total;
+}
+
+// First vehicle from another queue whose box would overlap a vehicle placed
+// at (x, y), optionally restricted by filter. Only the 3x3 neighbourhood of
+// cells is searched, since cells are as wide as the collision range.
+const Vehicle* findConflict(const SpatialGrid* grid, float x, float y, int queueIndex,
+                            bool (*filter)(const Vehicle* other)) {
+    Vehicle probe;
+    probe.x = x;
+    probe.y = y;
+
+    int center = cellOf(grid, x, y);
+    int cx = center % grid->cols, cy = center / grid->cols;
+    for (int dy = -1; dy <= 1; dy++) {
+        int row = cy + dy;
+        if (row < 0 || row >= grid->rows) continue;
+        for (int dx = -1; dx <= 1; dx++) {
+            int col = cx + dx;
+            if (col < 0 || col >= grid->cols) continue;
+            int cell = row * grid->cols + col;
+            for (int e = grid->cellHead[cell]; e >= 0; e = grid->entries[e].next) {
+                const GridEntry* entry = &grid->entries[e];
+                if (entry->queueIndex == queueIndex) continue;
+                if (filter && !filter(entry->vehicle)) continue;
+                if (checkCollision(&probe, entry->vehicle)) return entry->vehicle;
+            }
+        }
+    }
+    return NULL;
+}
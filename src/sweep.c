@@ -0,0 +1,356 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "junction.h"
+#include "lane_store.h"
+#include "event_sim.h"
+
+// Monte Carlo parameter sweep: every combination of light cycle, emergency
+// share, spawn interval and signal controller, each run over several seeds.
+// Each run owns its own Junction (queues, pool, RNG streams), so runs share
+// nothing and a pool of worker threads simply claims the next run index
+// until none are left.
+
+#define MAX_SWEEP_VALUES 32
+#define DEFAULT_SWEEP_SECONDS 3600
+#define DEFAULT_SWEEP_SEEDS 8
+
+typedef enum { SWEEP_QUEUE = 0, SWEEP_SOA, SWEEP_EVENT } SweepEngine;
+
+typedef struct {
+    JunctionConfig config;
+    int scenario;
+    long ticks;
+    SweepEngine engine;
+    // Results
+    bool failed;
+    long spawned;
+    long exited;
+    long drops;
+    int stranded;               // Still waiting to cross at the end; their waits so far are in waits
+    double wallSeconds;
+    DelayHistogram* waits;
+    DelayHistogram* latencies;  // Emergency detection to clearance
+} SweepRun;
+
+typedef struct {
+    SweepRun* runs;
+    int count;
+    atomic_int next;
+} SweepQueue;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Values below minimum are rejected: 0 is a valid emergency share, but not a cycle or interval.
+// So is a list longer than MAX_SWEEP_VALUES, rather than silently running part of it.
+static int parseIntList(const char* text, int values[MAX_SWEEP_VALUES], int minimum) {
+    int count = 0;
+    char* end;
+    while (*text) {
+        if (count == MAX_SWEEP_VALUES) return -1;
+        long value = strtol(text, &end, 10);
+        if (end == text || value < minimum) return -1;
+        values[count++] = (int)value;
+        text = (*end == ',') ? end + 1 : end;
+        if (*end && *end != ',') return -1;
+    }
+    return count;
+}
+
+// Controller names, comma separated, or "all"
+static int parseControllerList(const char* text, ControllerKind kinds[CONTROLLER_COUNT]) {
+    if (strcmp(text, "all") == 0) {
+        for (int k = 0; k < CONTROLLER_COUNT; k++) kinds[k] = (ControllerKind)k;
+        return CONTROLLER_COUNT;
+    }
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    int count = 0;
+    for (char* name = strtok(buffer, ","); name; name = strtok(NULL, ",")) {
+        if (count == CONTROLLER_COUNT) return -1;
+        kinds[count] = parseControllerKind(name);
+        if (kinds[count] == CONTROLLER_COUNT) return -1;
+        count++;
+    }
+    return count;
+}
+
+static void executeRun(SweepRun* run) {
+    double start = nowSeconds();
+    Junction* junction = createJunction(&run->config);
+    VehicleStore* store = NULL;
+    EventSim* events = NULL;
+    if (!junction ||
+        (run->engine == SWEEP_SOA && !(store = createVehicleStore(LANE_STORE_CAPACITY))) ||
+        (run->engine == SWEEP_EVENT && !(events = createEventSim(junction, NULL)))) {
+        run->failed = true;
+    } else if (events) {
+        run->failed = !runEventSim(events, (double)run->ticks * SIM_TICK_MS);
+    } else {
+        for (long t = 0; t < run->ticks; t++) {
+            if (store) stepVehicleStore(store, junction, NULL);
+            else stepJunction(junction, NULL);
+        }
+    }
+
+    if (junction && !run->failed) {
+        run->spawned = junction->vehiclesSpawned;
+        run->exited = junction->vehiclesExited;
+        run->drops = countQueueDrops(junction);
+        *run->waits = junction->waitStats;
+        // Otherwise a controller that starves a road looks better the fewer of its vehicles get through
+        run->stranded = events ? recordEventStranded(events, run->waits) :
+                        store ? recordStoreStranded(store, run->waits) : recordStranded(junction, run->waits);
+        *run->latencies = junction->emergencies->latency;
+    }
+    destroyEventSim(events);
+    destroyVehicleStore(store);
+    destroyJunction(junction);
+    run->wallSeconds = nowSeconds() - start;
+}
+
+static void* sweepWorker(void* arg) {
+    SweepQueue* queue = (SweepQueue*)arg;
+    int index;
+    while ((index = atomic_fetch_add(&queue->next, 1)) < queue->count) executeRun(&queue->runs[index]);
+    return NULL;
+}
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -c, --cycles LIST       Green time per phase in ms (default %d)\n"
+        "  -e, --emergency LIST    Emergency vehicle percentages (default %d)\n"
+        "  -i, --intervals LIST    Ticks between spawn rounds; lower is heavier traffic (default %d)\n"
+        "  -n, --seeds N           Runs per combination, seeds base..base+N-1 (default %d)\n"
+        "      --controllers LIST  Signal controllers to compare: fixed, actuated, max-pressure,\n"
+        "                          priority, or all (default fixed); priority's AL2 rule only\n"
+        "                          kicks in with --spawn-limit above 10\n"
+        "      --spawn-limit N     Built-in spawner skips roads with N vehicles queued (default %d)\n"
+        "      --preempt           Emergency vehicles preempt the lights (queue and event engines)\n"
+        "      --seed BASE         First seed (default 1)\n"
+        "  -s, --seconds S         Simulated seconds per run (default %d)\n"
+        "  -j, --threads N         Worker threads (default: online CPUs)\n"
+        "      --engine E          queue (default), soa (same results, faster) or event; event\n"
+        "                          delays are an approximation that ignores cross traffic and\n"
+        "                          can't be compared with queue or soa rows\n"
+        "      --csv PATH          Also write one row per run\n"
+        "  -h, --help              Show this help\n"
+        "LIST is comma separated, at most %d values, e.g. --cycles 3000,5000,8000\n"
+        "With several controllers, * marks the highest throughput among rows with the same other settings\n"
+        "Waits include the vehicles still waiting to cross when a run ends; stranded is how many\n"
+        "there were per run\n",
+        program, LIGHT_CYCLE_TIME, EMERGENCY_PERCENT, VEHICLE_GEN_INTERVAL,
+        DEFAULT_SWEEP_SEEDS, SPAWN_QUEUE_LIMIT, DEFAULT_SWEEP_SECONDS, MAX_SWEEP_VALUES);
+}
+
+int main(int argc, char* argv[]) {
+    int cycles[MAX_SWEEP_VALUES] = {LIGHT_CYCLE_TIME}, cycleCount = 1;
+    int emergency[MAX_SWEEP_VALUES] = {EMERGENCY_PERCENT}, emergencyCount = 1;
+    int intervals[MAX_SWEEP_VALUES] = {VEHICLE_GEN_INTERVAL}, intervalCount = 1;
+    ControllerKind controllers[CONTROLLER_COUNT] = {CONTROLLER_FIXED};
+    int controllerCount = 1;
+    int spawnLimit = SPAWN_QUEUE_LIMIT;
+    bool preempt = false;
+    int seeds = DEFAULT_SWEEP_SEEDS;
+    uint64_t baseSeed = 1;
+    double seconds = DEFAULT_SWEEP_SECONDS;
+    long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+    SweepEngine engine = SWEEP_QUEUE;
+    const char* csvPath = NULL;
+
+    static struct option options[] = {
+        {"cycles", required_argument, 0, 'c'},
+        {"emergency", required_argument, 0, 'e'},
+        {"intervals", required_argument, 0, 'i'},
+        {"seeds", required_argument, 0, 'n'},
+        {"controllers", required_argument, 0, 'K'},
+        {"spawn-limit", required_argument, 0, 'P'},
+        {"preempt", no_argument, 0, 'X'},
+        {"seed", required_argument, 0, 'R'},
+        {"seconds", required_argument, 0, 's'},
+        {"threads", required_argument, 0, 'j'},
+        {"engine", required_argument, 0, 'E'},
+        {"csv", required_argument, 0, 'C'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "c:e:i:n:s:j:h", options, NULL)) != -1) {
+        switch (opt) {
+            case 'c': cycleCount = parseIntList(optarg, cycles, 1); break;
+            case 'e': emergencyCount = parseIntList(optarg, emergency, 0); break;
+            case 'i': intervalCount = parseIntList(optarg, intervals, 1); break;
+            case 'n': seeds = atoi(optarg); break;
+            case 'K': controllerCount = parseControllerList(optarg, controllers); break;
+            case 'P': spawnLimit = atoi(optarg); break;
+            case 'X': preempt = true; break;
+            case 'R': baseSeed = parseSeed(optarg); break;
+            case 's': seconds = atof(optarg); break;
+            case 'j': threadCount = atol(optarg); break;
+            case 'C': csvPath = optarg; break;
+            case 'E':
+                if (strcmp(optarg, "soa") == 0) engine = SWEEP_SOA;
+                else if (strcmp(optarg, "event") == 0) engine = SWEEP_EVENT;
+                else if (strcmp(optarg, "queue") != 0) { printUsage(argv[0]); return 1; }
+                break;
+            case 'h': printUsage(argv[0]); return 0;
+            default: printUsage(argv[0]); return 1;
+        }
+    }
+    if (cycleCount <= 0 || emergencyCount <= 0 || intervalCount <= 0 || controllerCount <= 0 ||
+        seeds <= 0 || seconds <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (preempt && engine == SWEEP_SOA) {
+        fprintf(stderr, "The soa engine does not track individual vehicles; use --engine queue or event\n");
+        return 1;
+    }
+    if (threadCount <= 0) threadCount = 1;
+
+    int scenarios = cycleCount * emergencyCount * intervalCount * controllerCount;
+    int runCount = scenarios * seeds;
+    SweepRun* runs = (SweepRun*)calloc(runCount, sizeof(SweepRun));
+    DelayHistogram* waits = (DelayHistogram*)calloc(runCount, sizeof(DelayHistogram));
+    DelayHistogram* latencies = (DelayHistogram*)calloc(runCount, sizeof(DelayHistogram));
+    if (!runs || !waits || !latencies) {
+        fprintf(stderr, "Out of memory for %d runs\n", runCount);
+        return 1;
+    }
+
+    // Scenario-major order, so neighbouring runs differ only in seed, and
+    // neighbouring scenarios only in controller
+    int r = 0;
+    for (int c = 0; c < cycleCount; c++)
+        for (int e = 0; e < emergencyCount; e++)
+            for (int i = 0; i < intervalCount; i++)
+                for (int m = 0; m < controllerCount; m++)
+                    for (int k = 0; k < seeds; k++, r++) {
+                        SweepRun* run = &runs[r];
+                        defaultJunctionConfig(&run->config);
+                        run->config.seed = baseSeed + k;
+                        run->config.lightCycleMs = cycles[c];
+                        run->config.emergencyPercent = emergency[e];
+                        run->config.spawnIntervalTicks = intervals[i];
+                        run->config.spawnQueueLimit = spawnLimit;
+                        run->config.controller = controllers[m];
+                        run->config.preemption = preempt;
+                        run->scenario = r / seeds;
+                        run->ticks = (long)(seconds * 1000.0 / SIM_TICK_MS);
+                        run->engine = engine;
+                        run->waits = &waits[r];
+                        run->latencies = &latencies[r];
+                    }
+
+    SweepQueue queue = {runs, runCount, 0};
+    if (threadCount > runCount) threadCount = runCount;
+    pthread_t* threads = (pthread_t*)malloc(threadCount * sizeof(pthread_t));
+    double start = nowSeconds();
+    long started = 0;
+    for (long t = 0; threads && t < threadCount; t++) {
+        if (pthread_create(&threads[t], NULL, sweepWorker, &queue) != 0) break;
+        started++;
+    }
+    if (started == 0) sweepWorker(&queue);
+    for (long t = 0; t < started; t++) pthread_join(threads[t], NULL);
+    double elapsed = nowSeconds() - start;
+    free(threads);
+
+    printf("# %d runs (%d scenarios x %d seeds), %.0f simulated s each, %ld threads, %.2f s wall, %.0fx real time\n",
+        runCount, scenarios, seeds, seconds, started ? started : 1L, elapsed,
+        elapsed > 0 ? runCount * seconds / elapsed : 0.0);
+    printf("%8s %6s %8s %-12s %20s %9s %8s %8s %8s %8s %8s %8s %8s %6s\n",
+        "cycle_ms", "emerg%", "interval", "controller", "throughput/h", "wait_mean", "p50", "p95", "p99", "max",
+        "em_p95", "em_max", "stranded", "failed");
+
+    double* throughput = (double*)calloc(scenarios, sizeof(double));
+    double* spread = (double*)calloc(scenarios, sizeof(double));
+    DelayHistogram* merged = (DelayHistogram*)calloc(scenarios, sizeof(DelayHistogram));
+    DelayHistogram* mergedLatency = (DelayHistogram*)calloc(scenarios, sizeof(DelayHistogram));
+    double* stranded = (double*)calloc(scenarios, sizeof(double));
+    int* failures = (int*)calloc(scenarios, sizeof(int));
+    if (!throughput || !spread || !merged || !mergedLatency || !stranded || !failures) {
+        fprintf(stderr, "Out of memory for %d scenarios\n", scenarios);
+        return 1;
+    }
+    for (int s = 0; s < scenarios; s++) {
+        double sum = 0, sumSquares = 0;
+        int ok = 0;
+        for (int k = 0; k < seeds; k++) {
+            SweepRun* run = &runs[s * seeds + k];
+            if (run->failed) { failures[s]++; continue; }
+            double perHour = run->exited * 3600.0 / seconds;
+            sum += perHour;
+            sumSquares += perHour * perHour;
+            mergeDelayHistogram(&merged[s], run->waits);
+            mergeDelayHistogram(&mergedLatency[s], run->latencies);
+            stranded[s] += run->stranded;
+            ok++;
+        }
+        throughput[s] = ok ? sum / ok : 0.0;
+        if (ok) stranded[s] /= ok;
+        spread[s] = ok > 1 ? sqrt(fmax(0.0, (sumSquares - ok * throughput[s] * throughput[s]) / (ok - 1))) : 0.0;
+    }
+
+    for (int s = 0; s < scenarios; s++) {
+        // Scenarios that differ only in controller are adjacent
+        int group = s - s % controllerCount;
+        bool best = controllerCount > 1;
+        for (int g = group; g < group + controllerCount; g++) {
+            if (throughput[g] > throughput[s]) best = false;
+        }
+        const JunctionConfig* config = &runs[s * seeds].config;
+        printf("%8d %6d %8d %-12s %c%10.0f +- %5.0f %8.1fs %7.1fs %7.1fs %7.1fs %7.1fs %7.1fs %7.1fs %8.1f %6d\n",
+            config->lightCycleMs, config->emergencyPercent, config->spawnIntervalTicks,
+            signalController(config->controller)->name, best ? '*' : ' ', throughput[s], spread[s],
+            meanDelay(&merged[s]) / 1000.0, delayPercentile(&merged[s], 50) / 1000.0,
+            delayPercentile(&merged[s], 95) / 1000.0, delayPercentile(&merged[s], 99) / 1000.0,
+            merged[s].maxMs / 1000.0, delayPercentile(&mergedLatency[s], 95) / 1000.0,
+            mergedLatency[s].maxMs / 1000.0, stranded[s], failures[s]);
+    }
+    free(failures);
+    free(stranded);
+    free(mergedLatency);
+    free(merged);
+    free(spread);
+    free(throughput);
+
+    if (csvPath) {
+        FILE* csv = fopen(csvPath, "w");
+        if (!csv) {
+            perror(csvPath);
+        } else {
+            fprintf(csv, "cycle_ms,emergency_percent,spawn_interval,controller,seed,spawned,exited,drops,stranded,"
+                         "wait_mean_ms,wait_p95_ms,wait_max_ms,emergency_p95_ms,emergency_max_ms,wall_s,failed\n");
+            for (int i = 0; i < runCount; i++) {
+                SweepRun* run = &runs[i];
+                fprintf(csv, "%d,%d,%d,%s,%llu,%ld,%ld,%ld,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.3f,%d\n",
+                    run->config.lightCycleMs, run->config.emergencyPercent, run->config.spawnIntervalTicks,
+                    signalController(run->config.controller)->name,
+                    (unsigned long long)run->config.seed, run->spawned, run->exited, run->drops, run->stranded,
+                    meanDelay(run->waits), delayPercentile(run->waits, 95), run->waits->maxMs,
+                    delayPercentile(run->latencies, 95), run->latencies->maxMs,
+                    run->wallSeconds, run->failed ? 1 : 0);
+            }
+            fclose(csv);
+        }
+    }
+
+    free(latencies);
+    free(waits);
+    free(runs);
+    return 0;
+}
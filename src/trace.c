@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "trace.h"
+
+typedef struct {
+    const char* name;
+    uint64_t startNs;
+    uint64_t durationNs;
+} TraceEvent;
+
+// One per thread, never freed before exit; linked so the dumper can find them
+typedef struct TraceBuffer {
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+    atomic_ulong written;      // Total events ever recorded; ring index is written % size
+    int threadId;
+    struct TraceBuffer* next;
+} TraceBuffer;
+
+static _Thread_local TraceBuffer* threadBuffer;
+static _Atomic(TraceBuffer*) buffers;
+static atomic_int nextThreadId = 1;
+static volatile sig_atomic_t dumpRequested;
+static char tracePath[256] = TRACE_DEFAULT_PATH;
+static uint64_t traceEpochNs;
+static bool traceActive;
+
+static void onDumpSignal(int signo) {
+    (void)signo;
+    dumpRequested = 1;
+}
+
+void traceInit(const char* path) {
+    const char* env = getenv("TRACE_FILE");
+    if (env) path = env;
+    if (path) snprintf(tracePath, sizeof(tracePath), "%s", path);
+    traceEpochNs = traceNowNs();
+    traceActive = true;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onDumpSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+    atexit(traceShutdown);
+}
+
+static TraceBuffer* registerThreadBuffer(void) {
+    TraceBuffer* buffer = (TraceBuffer*)calloc(1, sizeof(TraceBuffer));
+    if (!buffer) return NULL;
+    buffer->threadId = atomic_fetch_add(&nextThreadId, 1);
+    TraceBuffer* head = atomic_load(&buffers);
+    do {
+        buffer->next = head;
+    } while (!atomic_compare_exchange_weak(&buffers, &head, buffer));
+    return buffer;
+}
+
+void traceRecord(const char* name, uint64_t startNs, uint64_t endNs) {
+    if (!traceActive) return;
+    TraceBuffer* buffer = threadBuffer;
+    if (!buffer && !(buffer = threadBuffer = registerThreadBuffer())) return;
+    unsigned long index = atomic_load_explicit(&buffer->written, memory_order_relaxed);
+    TraceEvent* event = &buffer->events[index % TRACE_BUFFER_EVENTS];
+    event->name = name;
+    event->startNs = startNs;
+    event->durationNs = endNs - startNs;
+    atomic_store_explicit(&buffer->written, index + 1, memory_order_release);
+}
+
+void tracePoll(void) {
+    if (dumpRequested) {
+        dumpRequested = 0;
+        traceDump();
+    }
+}
+
+// Writes every thread's retained events; a later dump replaces the file.
+// Other threads keep recording meanwhile, so the oldest events of a busy ring
+// may be overwritten mid-dump; viewers tolerate the odd torn entry.
+void traceDump(void) {
+    char tmpPath[sizeof(tracePath) + 8];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", tracePath);
+    FILE* file = fopen(tmpPath, "w");
+    if (!file) return;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"traffic simulator\"}}",
+            (int)getpid());
+    for (TraceBuffer* buffer = atomic_load(&buffers); buffer; buffer = buffer->next) {
+        unsigned long written = atomic_load_explicit(&buffer->written, memory_order_acquire);
+        unsigned long first = written > TRACE_BUFFER_EVENTS ? written - TRACE_BUFFER_EVENTS : 0;
+        for (unsigned long i = first; i < written; i++) {
+            const TraceEvent* event = &buffer->events[i % TRACE_BUFFER_EVENTS];
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+                    event->name, (event->startNs - traceEpochNs) / 1000.0,
+                    event->durationNs / 1000.0, (int)getpid(), buffer->threadId);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    rename(tmpPath, tracePath);
+}
+
+void traceShutdown(void) {
+    if (!traceActive) return;
+    traceDump();
+    traceActive = false;
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "vehicle_trace.h"
+#include "journey_log.h"
+#include "transport.h"
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+        "Usage: %s [--interval-ms N] INPUT.txt OUTPUT.vtr   convert text records to a binary trace\n"
+        "       %s --dump INPUT.vtr                        print a binary trace as text records\n"
+        "       %s --journeys INPUT.jrn                    print a journey log as CSV\n"
+        "Text records carry no timestamp; record i arrives at i * interval ms (default 0).\n",
+        program, program, program);
+}
+
+static int convertText(const char* input, const char* output, uint32_t intervalMs) {
+    FILE* in = fopen(input, "r");
+    if (!in) {
+        perror(input);
+        return 1;
+    }
+    TraceWriter* writer = openTraceWriter(output);
+    if (!writer) {
+        perror(output);
+        fclose(in);
+        return 1;
+    }
+
+    double start = nowSeconds();
+    char line[256];
+    uint64_t written = 0, skipped = 0;
+    while (fgets(line, sizeof(line), in)) {
+        Vehicle vehicle;
+        if (!parseVehicleLine(line, &vehicle)) {
+            skipped++;
+            continue;
+        }
+        TraceRecord record;
+        encodeTraceRecord(&vehicle, (uint32_t)(written * intervalMs), &record);
+        if (!writeTraceRecord(writer, &record)) {
+            fprintf(stderr, "Write to %s failed\n", output);
+            break;
+        }
+        written++;
+    }
+    fclose(in);
+    bool ok = closeTraceWriter(writer);
+
+    fprintf(stderr, "%llu records written, %llu lines skipped, %.3f s\n",
+        (unsigned long long)written, (unsigned long long)skipped, nowSeconds() - start);
+    return ok ? 0 : 1;
+}
+
+static int dumpTrace(const char* input) {
+    TraceReader* reader = openTraceReader(input);
+    if (!reader) {
+        fprintf(stderr, "Could not open trace %s\n", input);
+        return 1;
+    }
+    const TraceRecord* record;
+    while ((record = nextTraceRecord(reader))) {
+        Vehicle v;
+        decodeTraceRecord(record, &v);
+        printf("%d,%d,%d,%d,%d,%d,%f,%f,%f,%f,%d,%f,%d,%d\n",
+            v.vehicleId, v.type, v.startDirection, v.endDirection,
+            v.startLane, v.endLane, v.x, v.y, v.speed,
+            v.turnAngle, v.turning ? 1 : 0, v.progress, v.waitTime,
+            v.passedIntersection ? 1 : 0);
+    }
+    closeTraceReader(reader);
+    return 0;
+}
+
+static int dumpJourneys(const char* input) {
+    FILE* in = fopen(input, "rb");
+    if (!in) {
+        perror(input);
+        return 1;
+    }
+    JourneyHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != JOURNEY_MAGIC ||
+        header.version != JOURNEY_VERSION || header.recordSize != sizeof(JourneyRecord)) {
+        fprintf(stderr, "%s is not a version %d journey log\n", input, JOURNEY_VERSION);
+        fclose(in);
+        return 1;
+    }
+
+    JourneyRecord records[1024];
+    size_t n;
+    uint64_t count = 0, totalWait = 0;
+    printf("exitMs,vehicleId,type,startDirection,startLane,endDirection,endLane,waitMs\n");
+    while ((n = fread(records, sizeof(JourneyRecord), 1024, in)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            const JourneyRecord* r = &records[i];
+            printf("%llu,%u,%u,%d,%d,%d,%d,%llu\n",
+                (unsigned long long)r->exitTick * header.tickMs, r->vehicleId, r->type,
+                r->route & 3, (r->route >> 2) & 3, (r->route >> 4) & 3, (r->route >> 6) & 3,
+                (unsigned long long)r->waitTicks * header.tickMs);
+            totalWait += r->waitTicks;
+        }
+        count += n;
+    }
+    fclose(in);
+    fprintf(stderr, "%llu journeys, mean wait %.1f ms\n", (unsigned long long)count,
+        count ? (double)totalWait * header.tickMs / count : 0.0);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t intervalMs = 0;
+    const char* paths[2] = {NULL, NULL};
+    int pathCount = 0;
+    bool dump = false;
+    bool journeys = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--interval-ms") == 0 && i + 1 < argc) {
+            intervalMs = (uint32_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--dump") == 0) {
+            dump = true;
+        } else if (strcmp(argv[i], "--journeys") == 0) {
+            journeys = true;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (pathCount < 2) {
+            paths[pathCount++] = argv[i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (journeys && pathCount == 1) return dumpJourneys(paths[0]);
+    if (dump && pathCount == 1) return dumpTrace(paths[0]);
+    if (!dump && !journeys && pathCount == 2) return convertText(paths[0], paths[1], intervalMs);
+    printUsage(argv[0]);
+    return 1;
+}
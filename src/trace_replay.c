@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "trace_replay.h"
+#include "transport.h"
+
+#define STAMP_WRAP 4294967296.0   // 2^32 ms
+
+// Loads the next record and its simulated time
+static void advance(TraceReplay* replay) {
+    const TraceRecord* record = nextTraceRecord(replay->reader);
+    replay->pending = record;
+    if (!record) return;
+
+    uint32_t stamp = record->arrivalMs;
+    if (stamp < replay->lastStampMs) {
+        if (replay->lastStampMs - stamp > UINT32_MAX / 2) replay->epochMs += (uint64_t)STAMP_WRAP;
+        else replay->outOfOrder++;
+    }
+    replay->lastStampMs = stamp;
+    replay->pendingMs = (double)replay->epochMs + stamp - replay->firstStampMs;
+}
+
+TraceReplay* openTraceReplay(const char* path) {
+    TraceReader* reader = openTraceReader(path);
+    if (!reader) return NULL;
+    TraceReplay* replay = (TraceReplay*)calloc(1, sizeof(TraceReplay));
+    if (!replay) {
+        closeTraceReader(reader);
+        return NULL;
+    }
+    replay->reader = reader;
+    if (reader->count > 0) {
+        replay->firstStampMs = reader->records[0].arrivalMs;
+        replay->lastStampMs = replay->firstStampMs;
+    }
+    advance(replay);
+    return replay;
+}
+
+void closeTraceReplay(TraceReplay* replay) {
+    if (!replay) return;
+    closeTraceReader(replay->reader);
+    free(replay);
+}
+
+// Injects every record due by nowMs into its start lane. A full pool (or a
+// backpressured lane) leaves the record pending for the next call, so no
+// recorded arrival is lost to a momentary shortage.
+int replayArrivals(TraceReplay* replay, Queue* queues[], VehiclePool* pool, double nowMs) {
+    int count = 0;
+    while (replay->pending && replay->pendingMs <= nowMs) {
+        const TraceRecord* record = replay->pending;
+        int startLane = (record->route >> 2) & 3, endLane = (record->route >> 6) & 3;
+        if (startLane < 3 && endLane < 3) {
+            Vehicle vehicle;
+            decodeTraceRecord(record, &vehicle);
+            EnqueueResult result = admitVehicle(queues, pool, &vehicle);
+            if (result == ENQUEUE_BACKPRESSURE) break;
+            if (result == ENQUEUE_OK) count++;
+            else replay->rejected++;
+        } else {
+            replay->rejected++;
+        }
+        advance(replay);
+    }
+    replay->injected += count;
+    return count;
+}
+
+// Simulated time of the next record, or INFINITY once the trace is done
+double nextReplayMs(const TraceReplay* replay) {
+    return replay->pending ? replay->pendingMs : INFINITY;
+}
@@ -5,35 +5,32 @@
 #include <math.h>
 #include "traffic_generator.h"
 #include "queue.h"
+#include "socket_ingest.h"
 
 #define VEHICLE_GENERATION_INTERVAL 1000
 #define MIN_INTERVAL 500
 #define MAX_INTERVAL 2000
 #define EMERGENCY_VEHICLE_CHANCE 15
 
-void writeVehicleToFile(Vehicle* vehicle, const char* filename) {
-    if (!vehicle || !filename) return;
-    FILE* file = fopen(filename, "a");
-    if (!file) return;
+// One text record, in the format parseVehicleLine reads
+void writeVehicleLine(FILE* file, const Vehicle* vehicle) {
     fprintf(file, "%d,%d,%d,%d,%d,%d,%f,%f,%f,%f,%d,%f,%d,%d\n",
         vehicle->vehicleId, vehicle->type, vehicle->startDirection, vehicle->endDirection,
         vehicle->startLane, vehicle->endLane, vehicle->x, vehicle->y, vehicle->speed,
         vehicle->turnAngle, vehicle->turning ? 1 : 0, vehicle->progress, vehicle->waitTime,
         vehicle->passedIntersection ? 1 : 0);
-    fclose(file);
 }
 
-void generateVehicle(const char* filename) {
-    Vehicle* vehicle = (Vehicle*)malloc(sizeof(Vehicle));
-    if (!vehicle) return;
-
-    vehicle->vehicleId = rand() % 1000;
-    int typeRoll = rand() % 100;
-    vehicle->type = (typeRoll < EMERGENCY_VEHICLE_CHANCE) ? (1 + rand() % 3) : 0;
-    vehicle->startDirection = rand() % 4;
-    vehicle->startLane = rand() % 2; // Only L1 or L2
-    setVehiclePath(vehicle);
+void writeVehicleToFile(Vehicle* vehicle, const char* filename) {
+    if (!vehicle || !filename) return;
+    FILE* file = fopen(filename, "a");
+    if (!file) return;
+    writeVehicleLine(file, vehicle);
+    fclose(file);
+}
 
+// Positions a vehicle just outside the window on its start road and lane
+void placeVehicleAtEntry(Vehicle* vehicle) {
     float laneOffset = (vehicle->startLane + 0.5) * LANE_WIDTH;
     switch (vehicle->startDirection) {
         case DIRECTION_SOUTH: // A - from top
@@ -53,6 +50,19 @@ void generateVehicle(const char* filename) {
             vehicle->y = -VEHICLE_SIZE;
             break;
     }
+}
+
+static void drawVehicleType(Vehicle* vehicle, Rng* rng) {
+    vehicle->vehicleId = rngRange(rng, 1000);
+    int typeRoll = rngRange(rng, 100);
+    vehicle->type = (typeRoll < EMERGENCY_VEHICLE_CHANCE) ? (1 + rngRange(rng, 3)) : 0;
+}
+
+// Route, position and motion state once the start road and lane are known
+static void finishVehicle(Vehicle* vehicle, Rng* rng) {
+    setVehiclePath(vehicle, rng);
+
+    placeVehicleAtEntry(vehicle);
 
     vehicle->speed = (vehicle->type > 0) ? 3.0f : 2.0f;
     vehicle->turning = false;
@@ -61,24 +71,100 @@ void generateVehicle(const char* filename) {
     vehicle->waitTime = 0;
     vehicle->isPriorityLane = false;
     vehicle->passedIntersection = false;
+    vehicle->prevX = vehicle->x;
+    vehicle->prevY = vehicle->y;
+}
 
-    writeVehicleToFile(vehicle, filename);
-    free(vehicle);
+void buildVehicle(Vehicle* vehicle, Rng* rng) {
+    drawVehicleType(vehicle, rng);
+    vehicle->startDirection = rngRange(rng, 4);
+    vehicle->startLane = rngRange(rng, 2); // Only L1 or L2
+    finishVehicle(vehicle, rng);
 }
 
-void startVehicleGeneration(const char* filename) {
-    srand(time(NULL));
+// As buildVehicle, on a chosen road and lane
+void buildVehicleOnLane(Vehicle* vehicle, Rng* rng, Direction direction, LanePosition lane) {
+    drawVehicleType(vehicle, rng);
+    vehicle->startDirection = direction;
+    vehicle->startLane = lane;
+    finishVehicle(vehicle, rng);
+}
+
+void generateVehicle(const char* filename, Rng* rng) {
+    Vehicle vehicle;
+    buildVehicle(&vehicle, rng);
+    writeVehicleToFile(&vehicle, filename);
+}
+
+// Builds the vehicle directly in the shared ring slot; false if the ring is full
+bool generateVehicleToRing(VehicleRing* ring, Rng* rng) {
+    Vehicle* slot = reserveVehicleSlot(ring);
+    if (!slot) return false;
+    buildVehicle(slot, rng);
+    publishVehicleSlot(ring);
+    return true;
+}
+
+static int generationInterval(void) {
+    time_t now = time(NULL);
+    struct tm* timeinfo = localtime(&now);
+    int hour = timeinfo->tm_hour;
+    int interval = VEHICLE_GENERATION_INTERVAL;
+    if ((hour >= 7 && hour <= 9) || (hour >= 16 && hour <= 18)) interval = MIN_INTERVAL;
+    else if (hour >= 22 || hour <= 5) interval = MAX_INTERVAL;
+    return interval;
+}
+
+void startVehicleGeneration(const char* filename, uint64_t seed) {
+    Rng rng;
+    seedRng(&rng, seed, RNG_STREAM_GENERATOR);
     FILE* file = fopen(filename, "w");
     if (file) fclose(file);
 
     while (1) {
-        generateVehicle(filename);
-        time_t now = time(NULL);
-        struct tm* timeinfo = localtime(&now);
-        int hour = timeinfo->tm_hour;
-        int interval = VEHICLE_GENERATION_INTERVAL;
-        if ((hour >= 7 && hour <= 9) || (hour >= 16 && hour <= 18)) interval = MIN_INTERVAL;
-        else if (hour >= 22 || hour <= 5) interval = MAX_INTERVAL;
-        usleep(interval * 1000);
+        generateVehicle(filename, &rng);
+        usleep(generationInterval() * 1000);
+    }
+}
+
+void startVehicleGenerationToRing(VehicleRing* ring, uint64_t seed) {
+    Rng rng;
+    seedRng(&rng, seed, RNG_STREAM_GENERATOR);
+
+    while (1) {
+        // A full ring means the simulator is behind; back off instead of dropping
+        while (!generateVehicleToRing(ring, &rng)) usleep(1000);
+        usleep(generationInterval() * 1000);
+    }
+}
+
+// Streams batches to a simulator's socket server, connecting (and
+// reconnecting after a restart) whenever it is listening. A batch that could
+// not be delivered is resent on the next connection.
+void startVehicleGenerationToSocket(const char* path, uint64_t seed, int batch) {
+    Rng rng;
+    seedRng(&rng, seed, RNG_STREAM_GENERATOR);
+    if (batch < 1) batch = 1;
+    if (batch > SOCKET_BATCH_MAX) batch = SOCKET_BATCH_MAX;
+    Vehicle vehicles[SOCKET_BATCH_MAX];
+    bool pending = false;
+    int fd = -1;
+
+    while (1) {
+        if (fd < 0 && (fd = connectVehicleSocket(path)) < 0) {
+            usleep(100 * 1000);
+            continue;
+        }
+        if (!pending) {
+            for (int i = 0; i < batch; i++) buildVehicle(&vehicles[i], &rng);
+            pending = true;
+        }
+        if (!sendVehicleBatch(fd, vehicles, batch)) {
+            close(fd);
+            fd = -1;
+            continue;
+        }
+        pending = false;
+        usleep(generationInterval() * 1000);
     }
 }
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "transport.h"
+
+// fromStart only affects the file transport: see openFileIngest
+bool openTransport(Transport* transport, TransportKind kind, const char* path, bool fromStart) {
+    transport->kind = kind;
+    transport->path = path;
+    transport->ring = NULL;
+    transport->ingest = NULL;
+    transport->server = NULL;
+    transport->replay = NULL;
+
+    if (kind == TRANSPORT_FILE) {
+        transport->ingest = openFileIngest(path ? path : "vehicles.txt", fromStart);
+        if (!transport->ingest) {
+            fprintf(stderr, "Could not watch %s\n", path ? path : "vehicles.txt");
+            return false;
+        }
+    }
+    if (kind == TRANSPORT_SHM) {
+        transport->ring = openVehicleRing(path ? path : VEHICLE_RING_NAME, VEHICLE_RING_CAPACITY);
+        if (!transport->ring) {
+            fprintf(stderr, "Could not open shared-memory ring %s\n", path ? path : VEHICLE_RING_NAME);
+            return false;
+        }
+    }
+    if (kind == TRANSPORT_SOCKET) {
+        transport->server = openSocketIngest(path ? path : SOCKET_INGEST_PATH);
+        if (!transport->server) {
+            fprintf(stderr, "Could not listen on %s\n", path ? path : SOCKET_INGEST_PATH);
+            return false;
+        }
+    }
+    if (kind == TRANSPORT_REPLAY) {
+        transport->replay = path ? openTraceReplay(path) : NULL;
+        if (!transport->replay) {
+            fprintf(stderr, "Could not open trace %s\n", path ? path : "(none given)");
+            return false;
+        }
+    }
+    return true;
+}
+
+void closeTransport(Transport* transport) {
+    if (!transport) return;
+    if (transport->ring) closeVehicleRing(transport->ring);
+    closeFileIngest(transport->ingest);
+    closeSocketIngest(transport->server);
+    closeTraceReplay(transport->replay);
+    transport->ring = NULL;
+    transport->ingest = NULL;
+    transport->server = NULL;
+    transport->replay = NULL;
+    transport->kind = TRANSPORT_NONE;
+}
+
+TransportKind parseTransportKind(const char* name) {
+    if (!name) return TRANSPORT_NONE;
+    if (strcmp(name, "file") == 0) return TRANSPORT_FILE;
+    if (strcmp(name, "shm") == 0) return TRANSPORT_SHM;
+    if (strcmp(name, "socket") == 0) return TRANSPORT_SOCKET;
+    if (strcmp(name, "replay") == 0) return TRANSPORT_REPLAY;
+    return TRANSPORT_COUNT;
+}
+
+// Moves any waiting vehicles into their lane queues; returns how many arrived.
+// nowMs is the simulated time, which only a replayed trace depends on.
+int pollTransport(Transport* transport, Queue* queues[], VehiclePool* pool, double nowMs) {
+    switch (transport->kind) {
+        case TRANSPORT_FILE: return processVehiclesFromRing(queues, pool, transport->ingest->ring);
+        case TRANSPORT_SHM:  return processVehiclesFromRing(queues, pool, transport->ring);
+        case TRANSPORT_SOCKET: return processVehiclesFromRing(queues, pool, transport->server->ring);
+        case TRANSPORT_REPLAY: return replayArrivals(transport->replay, queues, pool, nowMs);
+        default:             return 0;
+    }
+}
+
+// Parses one text record; false if the line is malformed
+bool parseVehicleLine(const char* line, Vehicle* vehicle) {
+    int turning, passed;
+    int startDir, endDir, startLane, endLane; // Use ints for sscanf
+    int fields = sscanf(line, "%d,%d,%d,%d,%d,%d,%f,%f,%f,%f,%d,%f,%d,%d",
+        &vehicle->vehicleId, &vehicle->type, &startDir, &endDir,
+        &startLane, &endLane, &vehicle->x, &vehicle->y, &vehicle->speed,
+        &vehicle->turnAngle, &turning, &vehicle->progress, &vehicle->waitTime, &passed);
+    if (fields != 14) return false;
+    vehicle->startDirection = (Direction)startDir; // Cast to Direction
+    vehicle->endDirection = (Direction)endDir;     // Cast to Direction
+    vehicle->startLane = (LanePosition)startLane;  // Cast to LanePosition
+    vehicle->endLane = (LanePosition)endLane;      // Cast to LanePosition
+    vehicle->turning = turning;
+    vehicle->passedIntersection = passed;
+    vehicle->isPriorityLane = false;
+    vehicle->prevX = vehicle->x;
+    vehicle->prevY = vehicle->y;
+    return true;
+}
+
+// Copies a vehicle into the pool and onto its start lane. On refusal the pooled
+// copy is released; ENQUEUE_BACKPRESSURE (also returned when the pool is
+// empty) tells the caller to stop and retry later. Every transport comes
+// through here, so this is where out-of-range routes and types are rejected.
+EnqueueResult admitVehicle(Queue* queues[], VehiclePool* pool, const Vehicle* source) {
+    if ((unsigned)source->startDirection >= 4 || (unsigned)source->startLane >= 3 ||
+        (unsigned)source->endDirection >= 4 || (unsigned)source->endLane >= 3 ||
+        source->type < 0 || source->type > 3) {
+        return ENQUEUE_REJECTED;
+    }
+    int queueIndex = source->startDirection * 3 + source->startLane;
+    Vehicle* vehicle = allocVehicle(pool);
+    if (!vehicle) return ENQUEUE_BACKPRESSURE;
+    *vehicle = *source;
+    EnqueueResult result = enqueue(queues[queueIndex], vehicle);
+    if (result != ENQUEUE_OK) freeVehicle(pool, vehicle);
+    return result;
+}
+
+// Drains the ring in contiguous batches. Only the head/tail atomics are
+// touched per batch, so an idle frame costs no system calls.
+int processVehiclesFromRing(Queue* queues[], VehiclePool* pool, VehicleRing* ring) {
+    if (!ring) return 0;
+    int count = 0;
+    Vehicle* batch;
+    uint32_t n;
+    while ((n = peekVehicleBatch(ring, &batch, RING_DRAIN_BATCH)) > 0) {
+        for (uint32_t i = 0; i < n; i++) {
+            EnqueueResult result = admitVehicle(queues, pool, &batch[i]);
+            if (result == ENQUEUE_BACKPRESSURE) {
+                // Leave the rest in the ring; the producer sees it fill up
+                releaseVehicleBatch(ring, i);
+                return count;
+            }
+            if (result == ENQUEUE_OK) count++;
+        }
+        releaseVehicleBatch(ring, n);
+    }
+    return count;
+}
@@ -0,0 +1,56 @@
+#include <stdlib.h>
+#include "vehicle_pool.h"
+
+VehiclePool* createVehiclePool(int capacity) {
+    if (capacity <= 0) return NULL;
+    VehiclePool* pool = (VehiclePool*)calloc(1, sizeof(VehiclePool));
+    if (!pool) return NULL;
+
+    pool->slots = (Vehicle*)calloc(capacity, sizeof(Vehicle));
+    pool->freeList = (int*)malloc(capacity * sizeof(int));
+    if (!pool->slots || !pool->freeList) {
+        free(pool->slots);
+        free(pool->freeList);
+        free(pool);
+        return NULL;
+    }
+
+    // Lowest slots are handed out first so live vehicles stay packed together
+    for (int i = 0; i < capacity; i++) pool->freeList[i] = capacity - 1 - i;
+    pool->freeCount = capacity;
+    pool->capacity = capacity;
+    return pool;
+}
+
+void destroyVehiclePool(VehiclePool* pool) {
+    if (!pool) return;
+    free(pool->slots);
+    free(pool->freeList);
+    free(pool);
+}
+
+// Returns NULL when every slot is in use
+Vehicle* allocVehicle(VehiclePool* pool) {
+    if (pool->freeCount == 0) {
+        pool->exhausted++;
+        return NULL;
+    }
+    int index = pool->freeList[--pool->freeCount];
+    pool->inUse++;
+    pool->allocations++;
+    if (pool->inUse > pool->highWater) pool->highWater = pool->inUse;
+    return &pool->slots[index];
+}
+
+void freeVehicle(VehiclePool* pool, Vehicle* vehicle) {
+    int index = vehiclePoolIndex(pool, vehicle);
+    if (index < 0) return;
+    pool->freeList[pool->freeCount++] = index;
+    pool->inUse--;
+}
+
+// Slot number of a pooled vehicle, or -1 if it did not come from this pool
+int vehiclePoolIndex(const VehiclePool* pool, const Vehicle* vehicle) {
+    if (!pool || vehicle < pool->slots || vehicle >= pool->slots + pool->capacity) return -1;
+    return (int)(vehicle - pool->slots);
+}
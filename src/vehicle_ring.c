@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vehicle_ring.h"
+
+static size_t ringBytes(uint32_t capacity) {
+    return sizeof(VehicleRingShared) + (size_t)capacity * sizeof(Vehicle);
+}
+
+// Opens the named segment, creating and initialising it if this is the first
+// process to attach. Either the simulator or the generator may start first.
+VehicleRing* openVehicleRing(const char* name, uint32_t capacity) {
+    if (!name || capacity == 0 || (capacity & (capacity - 1)) != 0) return NULL;
+
+    VehicleRing* ring = (VehicleRing*)calloc(1, sizeof(VehicleRing));
+    if (!ring) return NULL;
+    snprintf(ring->name, sizeof(ring->name), "%s", name);
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+        ring->owner = true;
+        if (ftruncate(fd, ringBytes(capacity)) != 0) {
+            close(fd);
+            shm_unlink(name);
+            free(ring);
+            return NULL;
+        }
+    } else if (errno == EEXIST) {
+        fd = shm_open(name, O_RDWR, 0600);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(VehicleRingShared)) {
+            if (fd >= 0) close(fd);
+            free(ring);
+            return NULL;
+        }
+        capacity = (uint32_t)((st.st_size - sizeof(VehicleRingShared)) / sizeof(Vehicle));
+    } else {
+        free(ring);
+        return NULL;
+    }
+
+    ring->mappedSize = ringBytes(capacity);
+    void* mem = mmap(NULL, ring->mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        if (ring->owner) shm_unlink(name);
+        free(ring);
+        return NULL;
+    }
+    ring->shared = (VehicleRingShared*)mem;
+
+    if (ring->owner) {
+        ring->shared->recordSize = sizeof(Vehicle);
+        ring->shared->capacity = capacity;
+        atomic_init(&ring->shared->head, 0);
+        atomic_init(&ring->shared->tail, 0);
+        atomic_thread_fence(memory_order_release);
+        ring->shared->magic = VEHICLE_RING_MAGIC;
+    } else {
+        // The creator may still be initialising; wait briefly for the header
+        for (int i = 0; i < 1000 && ring->shared->magic != VEHICLE_RING_MAGIC; i++) usleep(1000);
+        atomic_thread_fence(memory_order_acquire);
+        if (ring->shared->magic != VEHICLE_RING_MAGIC ||
+            ring->shared->recordSize != sizeof(Vehicle) ||
+            ring->shared->capacity != capacity) {
+            fprintf(stderr, "Vehicle ring %s has an incompatible layout\n", name);
+            munmap(mem, ring->mappedSize);
+            free(ring);
+            return NULL;
+        }
+    }
+
+    ring->mask = capacity - 1;
+    ring->cachedHead = atomic_load_explicit(&ring->shared->head, memory_order_acquire);
+    ring->cachedTail = atomic_load_explicit(&ring->shared->tail, memory_order_acquire);
+    return ring;
+}
+
+// Same ring between two threads of one process; nothing is shared or named
+VehicleRing* createLocalVehicleRing(uint32_t capacity) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) return NULL;
+    VehicleRing* ring = (VehicleRing*)calloc(1, sizeof(VehicleRing));
+    if (!ring) return NULL;
+    ring->local = true;
+    ring->mappedSize = (ringBytes(capacity) + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+    ring->shared = (VehicleRingShared*)aligned_alloc(CACHE_LINE_SIZE, ring->mappedSize);
+    if (!ring->shared) {
+        free(ring);
+        return NULL;
+    }
+    ring->shared->magic = VEHICLE_RING_MAGIC;
+    ring->shared->recordSize = sizeof(Vehicle);
+    ring->shared->capacity = capacity;
+    atomic_init(&ring->shared->head, 0);
+    atomic_init(&ring->shared->tail, 0);
+    ring->mask = capacity - 1;
+    return ring;
+}
+
+void closeVehicleRing(VehicleRing* ring) {
+    if (!ring) return;
+    if (ring->local) {
+        free(ring->shared);
+        free(ring);
+        return;
+    }
+    munmap(ring->shared, ring->mappedSize);
+    if (ring->owner) shm_unlink(ring->name);
+    free(ring);
+}
+
+// Returns NULL when the ring is full; the caller decides whether to retry
+Vehicle* reserveVehicleSlot(VehicleRing* ring) {
+    uint64_t head = atomic_load_explicit(&ring->shared->head, memory_order_relaxed);
+    if (head - ring->cachedTail > ring->mask) {
+        ring->cachedTail = atomic_load_explicit(&ring->shared->tail, memory_order_acquire);
+        if (head - ring->cachedTail > ring->mask) return NULL;
+    }
+    return &ring->shared->slots[head & ring->mask];
+}
+
+void publishVehicleSlot(VehicleRing* ring) {
+    uint64_t head = atomic_load_explicit(&ring->shared->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->shared->head, head + 1, memory_order_release);
+}
+
+uint32_t peekVehicleBatch(VehicleRing* ring, Vehicle** first, uint32_t max) {
+    uint64_t tail = atomic_load_explicit(&ring->shared->tail, memory_order_relaxed);
+    if (ring->cachedHead == tail) {
+        ring->cachedHead = atomic_load_explicit(&ring->shared->head, memory_order_acquire);
+        if (ring->cachedHead == tail) return 0;
+    }
+
+    // Stop at the wrap point so the batch is contiguous
+    uint64_t available = ring->cachedHead - tail;
+    uint32_t index = (uint32_t)(tail & ring->mask);
+    uint32_t untilWrap = ring->mask + 1 - index;
+    uint32_t count = available < max ? (uint32_t)available : max;
+    if (count > untilWrap) count = untilWrap;
+
+    *first = &ring->shared->slots[index];
+    return count;
+}
+
+void releaseVehicleBatch(VehicleRing* ring, uint32_t count) {
+    uint64_t tail = atomic_load_explicit(&ring->shared->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->shared->tail, tail + count, memory_order_release);
+}
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vehicle_trace.h"
+#include "traffic_generator.h"
+
+_Static_assert(sizeof(TraceHeader) == 32, "TraceHeader must stay 32 bytes");
+_Static_assert(sizeof(TraceRecord) == 16, "TraceRecord must stay 16 bytes");
+_Static_assert(TRACE_WRITER_CHUNK % sizeof(TraceRecord) == 0, "Records must not straddle chunks");
+
+void encodeTraceRecord(const Vehicle* vehicle, uint32_t arrivalMs, TraceRecord* record) {
+    record->arrivalMs = arrivalMs;
+    record->vehicleId = (uint32_t)vehicle->vehicleId;
+    record->speedCenti = (uint16_t)(vehicle->speed * 100.0f + 0.5f);
+    record->waitTime = (uint16_t)(vehicle->waitTime > 0xFFFF ? 0xFFFF : vehicle->waitTime);
+    record->type = (uint8_t)vehicle->type;
+    record->route = (uint8_t)((vehicle->startDirection & 3) | (vehicle->startLane & 3) << 2 |
+                              (vehicle->endDirection & 3) << 4 | (vehicle->endLane & 3) << 6);
+    record->flags = (vehicle->turning ? TRACE_FLAG_TURNING : 0) |
+                    (vehicle->passedIntersection ? TRACE_FLAG_PASSED : 0);
+    record->reserved = 0;
+}
+
+void decodeTraceRecord(const TraceRecord* record, Vehicle* vehicle) {
+    vehicle->vehicleId = (int)record->vehicleId;
+    vehicle->type = record->type;
+    vehicle->startDirection = (Direction)(record->route & 3);
+    vehicle->startLane = (LanePosition)((record->route >> 2) & 3);
+    vehicle->endDirection = (Direction)((record->route >> 4) & 3);
+    vehicle->endLane = (LanePosition)((record->route >> 6) & 3);
+    vehicle->speed = record->speedCenti / 100.0f;
+    vehicle->waitTime = record->waitTime;
+    vehicle->turning = (record->flags & TRACE_FLAG_TURNING) != 0;
+    vehicle->passedIntersection = (record->flags & TRACE_FLAG_PASSED) != 0;
+    vehicle->turnAngle = 0.0f;
+    vehicle->progress = 0.0f;
+    vehicle->isPriorityLane = false;
+    placeVehicleAtEntry(vehicle);
+    vehicle->prevX = vehicle->x;
+    vehicle->prevY = vehicle->y;
+}
+
+TraceReader* openTraceReader(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TraceHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    void* mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mem == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    madvise(mem, st.st_size, MADV_SEQUENTIAL);
+
+    const TraceHeader* header = (const TraceHeader*)mem;
+    uint64_t available = (st.st_size - sizeof(TraceHeader)) / sizeof(TraceRecord);
+    if (header->magic != TRACE_MAGIC || header->version != TRACE_VERSION ||
+        header->recordSize != sizeof(TraceRecord) || header->recordCount > available) {
+        fprintf(stderr, "%s is not a version %d vehicle trace\n", path, TRACE_VERSION);
+        munmap(mem, st.st_size);
+        close(fd);
+        return NULL;
+    }
+
+    TraceReader* reader = (TraceReader*)calloc(1, sizeof(TraceReader));
+    if (!reader) {
+        munmap(mem, st.st_size);
+        close(fd);
+        return NULL;
+    }
+    reader->fd = fd;
+    reader->base = (const uint8_t*)mem;
+    reader->mappedSize = st.st_size;
+    reader->records = (const TraceRecord*)(reader->base + sizeof(TraceHeader));
+    reader->count = header->recordCount;
+    reader->cursor = 0;
+    return reader;
+}
+
+// Returns the next record straight out of the mapping, or NULL at the end.
+// Pages well behind the cursor are dropped, so a long sequential read keeps
+// a bounded resident set instead of the whole file.
+const TraceRecord* nextTraceRecord(TraceReader* reader) {
+    if (reader->cursor >= reader->count) return NULL;
+    const TraceRecord* record = &reader->records[reader->cursor++];
+    size_t offset = (const uint8_t*)record - reader->base;
+    if (offset - reader->released >= 2 * (size_t)TRACE_READER_RELEASE) {
+        madvise((void*)(reader->base + reader->released), TRACE_READER_RELEASE, MADV_DONTNEED);
+        reader->released += TRACE_READER_RELEASE;
+    }
+    return record;
+}
+
+void closeTraceReader(TraceReader* reader) {
+    if (!reader) return;
+    munmap((void*)reader->base, reader->mappedSize);
+    close(reader->fd);
+    free(reader);
+}
+
+// Grows the file and maps the chunk that starts at offset
+static bool mapWriterWindow(TraceWriter* writer, uint64_t offset) {
+    if (writer->window) munmap(writer->window, TRACE_WRITER_CHUNK);
+    writer->window = NULL;
+    if (ftruncate(writer->fd, offset + TRACE_WRITER_CHUNK) != 0) return false;
+    void* mem = mmap(NULL, TRACE_WRITER_CHUNK, PROT_READ | PROT_WRITE, MAP_SHARED, writer->fd, offset);
+    if (mem == MAP_FAILED) return false;
+    writer->window = (uint8_t*)mem;
+    writer->windowOffset = offset;
+    return true;
+}
+
+TraceWriter* openTraceWriter(const char* path) {
+    TraceWriter* writer = (TraceWriter*)calloc(1, sizeof(TraceWriter));
+    if (!writer) return NULL;
+    writer->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0 || !mapWriterWindow(writer, 0)) {
+        if (writer->fd >= 0) close(writer->fd);
+        free(writer);
+        return NULL;
+    }
+    memset(writer->window, 0, sizeof(TraceHeader));
+    return writer;
+}
+
+bool writeTraceRecord(TraceWriter* writer, const TraceRecord* record) {
+    uint64_t offset = sizeof(TraceHeader) + writer->count * sizeof(TraceRecord);
+    if (offset >= writer->windowOffset + TRACE_WRITER_CHUNK) {
+        if (!mapWriterWindow(writer, writer->windowOffset + TRACE_WRITER_CHUNK)) return false;
+    }
+    memcpy(writer->window + (offset - writer->windowOffset), record, sizeof(TraceRecord));
+    writer->count++;
+    return true;
+}
+
+// Writes the final header and trims the file to the records actually written
+bool closeTraceWriter(TraceWriter* writer) {
+    if (!writer) return false;
+    bool ok = writer->window != NULL;
+    if (writer->window) munmap(writer->window, TRACE_WRITER_CHUNK);
+
+    TraceHeader header = {0};
+    header.magic = TRACE_MAGIC;
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.recordCount = writer->count;
+    uint64_t size = sizeof(TraceHeader) + writer->count * sizeof(TraceRecord);
+    if (ftruncate(writer->fd, size) != 0) ok = false;
+    if (pwrite(writer->fd, &header, sizeof(header), 0) != sizeof(header)) ok = false;
+    close(writer->fd);
+    free(writer);
+    return ok;
+}